@@ -4,20 +4,21 @@
 */
 
 #include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include "list_tree.h"
-
-struct _list_tree_node_t {
-  void *data;
-  list_tree_node_t *next;
-  list_tree_node_t *first_child;
-};
+#include "list_tree_arena.h"
+#include "list_tree_node.h"
 
 void*
 list_tree_get_data(
     list_tree_node_t *node)
 {
+  if (0 != (node->flags & NODE_LAZY))
+    list_tree_lazy_touch(node, 0);
+
   return node->data;
 }
 
@@ -25,14 +26,14 @@ list_tree_node_t*
 list_tree_get_next(
     list_tree_node_t *node)
 {
-  return node->next;
+  return list_tree_node_next(node);
 }
 
 list_tree_node_t*
 list_tree_get_first_child(
     list_tree_node_t *node)
 {
-  return node->first_child;
+  return list_tree_node_first_child(node);
 }
 
 list_tree_node_t*
@@ -48,57 +49,192 @@ list_tree_make(
     list_tree_node_t *next,
     list_tree_node_t *first_child)
 {
-  list_tree_node_t *node =
-    (list_tree_node_t*) malloc(sizeof(list_tree_node_t));
+  return list_tree_arena_make(
+      NULL,
+      data,
+      next,
+      first_child);
+}
 
-  node->data = data;
-  node->next = next;
-  node->first_child = first_child;
+typedef struct _generate_level_t
+{
+  path_item_t item;
+  list_tree_node_t **slot;
+  void *parent_data;
+  void *scratch;
+} generate_level_t;
 
-  return node;
+/*
+  Each level of the stack holds the path item of the node being
+  generated at that depth and the place to link it to: the first
+  child of the parent for the first node of a list, the next of
+  the previous node for the others.  Path items refer to those of
+  the enclosing levels, so they are relinked whenever the stack
+  is moved by realloc.
+*/
+void
+list_tree_generate_list_ex(
+    list_tree_arena_t *arena,
+    node_generator_ex_t generator,
+    void *state,
+    path_item_t const* parent_path,
+    void *parent_data,
+    list_tree_node_t **slot)
+{
+  assert(NULL != slot);
+
+  size_t base_depth = 0;
+  for (path_item_t const* item = parent_path; NULL != item; item = item->prev)
+    ++ base_depth;
+
+  size_t capacity = 64;
+  size_t size = 1;
+  generate_level_t *levels = (generate_level_t*) malloc(
+      capacity * sizeof(generate_level_t));
+
+  assert(NULL != levels);
+
+  levels[0].item.index = 0;
+  levels[0].item.prev = parent_path;
+  levels[0].slot = slot;
+  levels[0].parent_data = parent_data;
+  levels[0].scratch = NULL;
+  *slot = NULL;
+
+  while (0 != size)
+  {
+    generate_level_t *top = &levels[size - 1];
+    void *data;
+
+    generator_context_t context =
+    {
+      &top->item,
+      base_depth + size - 1,
+      top->item.index,
+      top->parent_data,
+      &top->scratch
+    };
+
+    if (!generator(&context, state, &data))
+    {
+      if (0 != -- size)
+        ++ levels[size - 1].item.index;
+
+      continue;
+    }
+
+    list_tree_node_t *node = list_tree_arena_make(
+        arena,
+        data,
+        NULL,
+        NULL);
+
+    *top->slot = node;
+    top->slot = &node->next;
+
+    if (size == capacity)
+    {
+      capacity *= 2;
+      levels = (generate_level_t*) realloc(
+          levels,
+          capacity * sizeof(generate_level_t));
+
+      assert(NULL != levels);
+
+      for (size_t i = 1; i < size; ++i)
+        levels[i].item.prev = &levels[i - 1].item;
+    }
+
+    levels[size].item.index = 0;
+    levels[size].item.prev = &levels[size - 1].item;
+    levels[size].slot = &node->first_child;
+    levels[size].parent_data = data;
+    levels[size].scratch = NULL;
+    ++ size;
+  }
+
+  free(levels);
 }
 
-static
-list_tree_node_t*
-list_tree_generate_helper(
-    node_generator_t generator,
-    path_item_t const* path,
-    void *state)
+typedef struct _generate_adapter_t
 {
-  assert(NULL != path);
-  void *data;
+  node_generator_t generator;
+  void *state;
+} generate_adapter_t;
 
-  int is_existing = generator(path, state, &data);
+static
+int
+generate_adapter(
+    generator_context_t const* context,
+    void *raw_adapter,
+    void **data)
+{
+  generate_adapter_t *adapter = (generate_adapter_t*) raw_adapter;
 
-  if (!is_existing)
-    return NULL;
+  return adapter->generator(
+      context->path,
+      adapter->state,
+      data);
+}
 
-  path_item_t child_path =
+void
+list_tree_generate_list(
+    list_tree_arena_t *arena,
+    node_generator_t generator,
+    void *state,
+    path_item_t const* parent_path,
+    list_tree_node_t **slot)
+{
+  generate_adapter_t adapter =
   {
-    0,
-    path
+    generator,
+    state
   };
 
-  list_tree_node_t *child = list_tree_generate_helper(
+  list_tree_generate_list_ex(
+      arena,
+      generate_adapter,
+      &adapter,
+      parent_path,
+      NULL,
+      slot);
+}
+
+list_tree_node_t*
+list_tree_arena_generate(
+    list_tree_arena_t *arena,
+    node_generator_t generator,
+    void *state)
+{
+  list_tree_node_t *root;
+
+  list_tree_generate_list(
+      arena,
       generator,
-      &child_path,
-      state);
+      state,
+      NULL,
+      &root);
 
-  path_item_t next_path =
-  {
-    path->index + 1,
-    path->prev
-  };
+  return root;
+}
+
+list_tree_node_t*
+list_tree_arena_generate_ex(
+    list_tree_arena_t *arena,
+    node_generator_ex_t generator,
+    void *state)
+{
+  list_tree_node_t *root;
 
-  list_tree_node_t *next = list_tree_generate_helper(
+  list_tree_generate_list_ex(
+      arena,
       generator,
-      &next_path,
-      state);
+      state,
+      NULL,
+      NULL,
+      &root);
 
-  return list_tree_make(
-      data,
-      next,
-      child);
+  return root;
 }
 
 list_tree_node_t*
@@ -106,171 +242,1027 @@ list_tree_generate(
     node_generator_t generator,
     void *state)
 {
-  path_item_t root =
-  {
-    0,
-    NULL
-  };
+  return list_tree_arena_generate(
+      NULL,
+      generator,
+      state);
+}
 
-  return list_tree_generate_helper(
+list_tree_node_t*
+list_tree_generate_ex(
+    node_generator_ex_t generator,
+    void *state)
+{
+  return list_tree_arena_generate_ex(
+      NULL,
       generator,
-      &root,
       state);
 }
 
+static
+int
+is_augmented(
+    list_tree_node_t const* node)
+{
+  return NULL != node && 0 != (node->flags & NODE_AUGMENTED);
+}
+
+static
+list_tree_augment_list_t*
+augmented_list_of(
+    list_tree_node_t const* node)
+{
+  assert(is_augmented(node));
+
+  return list_tree_augment_of(node)->list;
+}
+
+static
+list_tree_augment_list_t*
+augmented_list_make(
+    list_tree_node_t *parent,
+    list_tree_node_t *first)
+{
+  list_tree_augment_list_t *list = (list_tree_augment_list_t*) malloc(
+      sizeof(list_tree_augment_list_t));
+
+  assert(NULL != list);
+
+  list->parent = parent;
+  list->first = first;
+  list->count = 0;
+  list->size = 0;
+  list->height = 0;
+  list->hasher = NULL;
+
+  return list;
+}
+
+static
+void
+augmented_join(
+    list_tree_augment_list_t *list,
+    list_tree_node_t *node)
+{
+  list_tree_augment_of(node)->list = list;
+  ++ list->count;
+}
+
+/*
+  Account for a subtree of the given size and height added to the
+  list, and then to each list up to the root, through the parents.
+  Only insertions are possible, so heights never decrease.  The
+  cached hashes on the way are dropped.
+*/
+static
+void
+augmented_grow(
+    list_tree_augment_list_t *list,
+    size_t size,
+    size_t height)
+{
+  while (NULL != list)
+  {
+    list->size += size;
+    list->hasher = NULL;
+
+    if (list->height < height)
+      list->height = height;
+
+    if (NULL == list->parent)
+      break;
+
+    list_tree_augment_t *augment = list_tree_augment_of(list->parent);
+
+    augment->size += size;
+    augment->height = 1 + list->height;
+    augment->hasher = NULL;
+
+    height = augment->height;
+    list = augment->list;
+  }
+}
+
+/* A list not linked from any node yet */
+static
+list_tree_augment_list_t*
+augmented_free_list(
+    list_tree_node_t *first)
+{
+  list_tree_augment_list_t *list = augmented_list_of(first);
+
+  assert(NULL == list->parent);
+  assert(first == list->first);
+
+  return list;
+}
+
+list_tree_node_t*
+list_tree_make_augmented(
+    void *data,
+    list_tree_node_t *next,
+    list_tree_node_t *first_child)
+{
+  list_tree_augment_t *augment = (list_tree_augment_t*) malloc(
+      sizeof(list_tree_augment_t) + sizeof(list_tree_node_t));
+
+  assert(NULL != augment);
+
+  list_tree_node_t *node = (list_tree_node_t*) (augment + 1);
+
+  node->data = data;
+  node->next = next;
+  node->first_child = first_child;
+  node->flags = NODE_AUGMENTED;
+  augment->size = 1;
+  augment->height = 1;
+  augment->hasher = NULL;
+
+  if (NULL != first_child)
+  {
+    list_tree_augment_list_t *children = augmented_free_list(first_child);
+
+    children->parent = node;
+    augment->size += children->size;
+    augment->height += children->height;
+  }
+
+  list_tree_augment_list_t *list = NULL == next
+    ? augmented_list_make(NULL, node)
+    : augmented_free_list(next);
+
+  list->first = node;
+  augmented_join(list, node);
+  augmented_grow(list, augment->size, augment->height);
+
+  return node;
+}
+
+void
+list_tree_node_free(
+    list_tree_node_t *node)
+{
+  if (is_augmented(node))
+  {
+    list_tree_augment_list_t *list = augmented_list_of(node);
+
+    free(list_tree_augment_of(node));
+
+    if (0 == -- list->count)
+      free(list);
+  }
+  else if (0 != (node->flags & NODE_LAZY))
+    list_tree_lazy_free(node);
+  else if (0 != (node->flags & NODE_SHARED))
+    free(list_tree_shared_of(node));
+  else
+  {
+    assert(0 == (node->flags & NODE_ARENA));
+    free(node);
+  }
+}
+
+list_tree_node_t*
+list_tree_make_inline(
+    void const* payload,
+    size_t payload_size,
+    list_tree_node_t *next,
+    list_tree_node_t *first_child)
+{
+  list_tree_node_t *node = (list_tree_node_t*) malloc(
+      list_tree_inline_size(payload_size));
+
+  assert(NULL != node);
+
+  return list_tree_inline_init(
+      node,
+      payload,
+      payload_size,
+      next,
+      first_child);
+}
+
+void*
+list_tree_get_payload(
+    list_tree_node_t *node)
+{
+  assert(NULL != node);
+  assert(0 != (node->flags & NODE_INLINE));
+
+  return ((list_tree_inline_t*) node)->payload;
+}
+
+/*
+  Parent is the node *first belongs to, which is only known here
+  from the metadata of *first itself when the list is not empty.
+  The new node leaves its own singleton list for the target one.
+*/
+static
+void
+list_tree_prepend_to(
+    list_tree_node_t *parent,
+    list_tree_node_t **first,
+    list_tree_node_t *tree)
+{
+  assert(NULL != first);
+  assert(NULL != tree);
+  assert(NULL == tree->next);
+
+  list_tree_node_t *old_first = *first;
+
+  tree->next = old_first;
+  *first = tree;
+
+  if (is_augmented(tree))
+  {
+    list_tree_augment_t *augment = list_tree_augment_of(tree);
+    list_tree_augment_list_t *list;
+
+    assert(1 == augmented_list_of(tree)->count);
+
+    free(augmented_free_list(tree));
+
+    if (NULL == old_first)
+    {
+      list = augmented_list_make(parent, tree);
+    }
+    else
+    {
+      list = augmented_list_of(old_first);
+
+      assert(NULL == parent || list->parent == parent);
+
+      if (list->first == old_first)
+        list->first = tree;
+    }
+
+    augmented_join(list, tree);
+    augmented_grow(list, augment->size, augment->height);
+  }
+}
+
 void
 list_tree_prepend(
     list_tree_node_t **first,
     list_tree_node_t *tree)
 {
   assert(NULL != first);
+
+  list_tree_prepend_to(
+      is_augmented(*first) ? augmented_list_of(*first)->parent : NULL,
+      first,
+      tree);
+}
+
+/* The nodes of the appendant move over to the list of last one by one */
+void
+list_tree_append(
+    list_tree_node_t *last,
+    list_tree_node_t *appendant)
+{
+  assert(NULL != last);
+  assert(NULL == last->next);
+
+  last->next = appendant;
+
+  if (is_augmented(last) && NULL != appendant)
+  {
+    list_tree_augment_list_t *list = augmented_list_of(last);
+    list_tree_augment_list_t *old_list = augmented_free_list(appendant);
+
+    for (list_tree_node_t *node = appendant; NULL != node; node = node->next)
+      augmented_join(list, node);
+
+    augmented_grow(list, old_list->size, old_list->height);
+    free(old_list);
+  }
+}
+
+list_tree_node_t*
+list_tree_prepend_child(
+    list_tree_node_t *parent,
+    list_tree_node_t *new_child)
+{
+  list_tree_prepend_to(
+      parent,
+      &parent->first_child,
+      new_child);
+
+  return new_child;
+}
+
+/*
+  The next link of the new node is written before the node is
+  published by the release of a successful exchange, and readers
+  load links with acquire, so they see it complete.  Losing the
+  race just means retrying with the new head.
+*/
+void
+list_tree_prepend_concurrent(
+    list_tree_node_t **first,
+    list_tree_node_t *tree)
+{
+  assert(NULL != first);
   assert(NULL != tree);
   assert(NULL == tree->next);
+  assert(!is_augmented(tree));
+
+  list_tree_node_t *head = __atomic_load_n(first, __ATOMIC_RELAXED);
+
+  do
+  {
+    tree->next = head;
+  }
+  while (!__atomic_compare_exchange_n(
+      first,
+      &head,
+      tree,
+      1,
+      __ATOMIC_RELEASE,
+      __ATOMIC_RELAXED));
+}
+
+list_tree_node_t*
+list_tree_prepend_child_concurrent(
+    list_tree_node_t *parent,
+    list_tree_node_t *new_child)
+{
+  assert(NULL != parent);
+
+  list_tree_prepend_concurrent(
+      &parent->first_child,
+      new_child);
+
+  return new_child;
+}
+
+/*
+  A node having a first child is rotated below it: the child takes
+  its place, the node becomes the next of the child and takes over
+  the old next of the child as its first child.  All nodes stay
+  reachable from the root without any stack, and each rotation
+  moves a node out of a first child link for good, so the work is
+  linear in the number of nodes.  Links are read as stored, so
+  parts of lazy trees that have not been generated are not
+  generated.
+*/
+size_t
+list_tree_free_nodes(
+    list_tree_node_t **root,
+    data_disposer_t disposer,
+    size_t budget)
+{
+  list_tree_node_t *node = *root;
+  size_t count = 0;
+
+  while (NULL != node && count < budget)
+  {
+    list_tree_node_t *child = node->first_child;
+
+    ++ count;
+
+    if (NULL != child)
+    {
+      node->first_child = child->next;
+      child->next = node;
+      node = child;
+      continue;
+    }
+
+    list_tree_node_t *next = node->next;
+
+    if (NULL != disposer && 0 == (node->flags & NODE_INLINE))
+      disposer(node->data);
+
+    list_tree_node_free(node);
+    node = next;
+  }
+
+  *root = node;
+
+  return count;
+}
+
+void
+list_tree_dispose(
+    list_tree_node_t *root,
+    data_disposer_t data_disposer)
+{
+  list_tree_free_nodes(&root, data_disposer, SIZE_MAX);
+}
+
+typedef enum _traverse_phase_t
+{
+  TRAVERSE_PRE,
+  TRAVERSE_ASCENT,
+  TRAVERSE_NEXT,
+  TRAVERSE_BACKWARD,
+  TRAVERSE_POST
+} traverse_phase_t;
+
+typedef struct _traverse_frame_t
+{
+  list_tree_node_t *node;
+  traverse_phase_t phase;
+} traverse_frame_t;
+
+enum { TRAVERSE_STACK_RESERVE = 64 };
+
+/*
+  Explicit stack of the traversal.  The first frames live in the
+  stack object itself so that shallow trees never touch the heap;
+  deeper ones spill into a growable heap buffer.
+*/
+typedef struct _traverse_stack_t
+{
+  traverse_frame_t *frames;
+  size_t size;
+  size_t capacity;
+  traverse_frame_t reserve[TRAVERSE_STACK_RESERVE];
+} traverse_stack_t;
+
+static
+void
+traverse_stack_init(
+    traverse_stack_t *stack)
+{
+  stack->frames = stack->reserve;
+  stack->size = 0;
+  stack->capacity = TRAVERSE_STACK_RESERVE;
+}
+
+static
+void
+traverse_stack_dispose(
+    traverse_stack_t *stack)
+{
+  if (stack->reserve != stack->frames)
+    free(stack->frames);
+}
+
+static
+void
+traverse_stack_push(
+    traverse_stack_t *stack,
+    list_tree_node_t *node)
+{
+  if (stack->size == stack->capacity)
+  {
+    size_t capacity = 2 * stack->capacity;
+    traverse_frame_t *frames;
+
+    if (stack->reserve == stack->frames)
+    {
+      frames = (traverse_frame_t*) malloc(
+          capacity * sizeof(traverse_frame_t));
+      assert(NULL != frames);
+      memcpy(frames, stack->frames, stack->size * sizeof(traverse_frame_t));
+    }
+    else
+    {
+      frames = (traverse_frame_t*) realloc(
+          stack->frames,
+          capacity * sizeof(traverse_frame_t));
+      assert(NULL != frames);
+    }
+
+    stack->frames = frames;
+    stack->capacity = capacity;
+  }
+
+  stack->frames[stack->size].node = node;
+  stack->frames[stack->size].phase = TRAVERSE_PRE;
+  ++ stack->size;
+}
+
+/*
+  Each frame walks through the phases of a single node in the
+  order prescribed by the contract in list_tree.h.  When there is
+  nothing to do after returning from the next node (neither
+  backward nor post_visitor is given), the frame is simply reused
+  for the next node, so a list of any length occupies one frame.
+
+  When prefetching, the next node of a node with children is
+  requested from memory on descending to its first child: it is
+  only needed after the whole subtree of the child has been
+  visited, so fetching it overlaps with that walk.  The link is
+  read without touching lazy nodes, so a pending one is just not
+  prefetched.
+*/
+static
+void
+traverse_depth(
+    list_tree_node_t *root,
+    list_tree_pre_visitor_t pre_visitor,
+    list_tree_enter_notifier_t descent,
+    list_tree_leave_notifier_t ascent,
+    list_tree_enter_notifier_t forward,
+    list_tree_leave_notifier_t backward,
+    list_tree_post_visitor_t post_visitor,
+    void *state,
+    int is_prefetching)
+{
+  if (NULL == root)
+    return;
+
+  int is_tail_next = (NULL == backward) && (NULL == post_visitor);
+
+  traverse_stack_t stack;
+  traverse_stack_init(&stack);
+  traverse_stack_push(&stack, root);
+
+  while (0 != stack.size)
+  {
+    traverse_frame_t *frame = &stack.frames[stack.size - 1];
+    list_tree_node_t *node = frame->node;
+    list_tree_node_t *first_child;
+    list_tree_node_t *next;
+
+    switch (frame->phase)
+    {
+      case TRAVERSE_PRE:
+        if ((NULL != pre_visitor) && !pre_visitor(node, state))
+        {
+          -- stack.size;
+          break;
+        }
+
+        first_child = list_tree_node_first_child(node);
+
+        if ((NULL != first_child) && ((NULL == descent) || descent(state)))
+        {
+          if (is_prefetching)
+            __builtin_prefetch(__atomic_load_n(&node->next, __ATOMIC_RELAXED));
+
+          frame->phase = TRAVERSE_ASCENT;
+          traverse_stack_push(&stack, first_child);
+          break;
+        }
+
+        frame->phase = TRAVERSE_NEXT;
+        break;
+
+      case TRAVERSE_ASCENT:
+        if (NULL != ascent)
+          ascent(state);
+
+        frame->phase = TRAVERSE_NEXT;
+        break;
+
+      case TRAVERSE_NEXT:
+        next = list_tree_node_next(node);
+
+        if ((NULL != next) && ((NULL == forward) || forward(state)))
+        {
+          if (is_tail_next)
+          {
+            frame->node = next;
+            frame->phase = TRAVERSE_PRE;
+          }
+          else
+          {
+            frame->phase = TRAVERSE_BACKWARD;
+            traverse_stack_push(&stack, next);
+          }
+          break;
+        }
+
+        frame->phase = TRAVERSE_POST;
+        break;
+
+      case TRAVERSE_BACKWARD:
+        if (NULL != backward)
+          backward(state);
+
+        frame->phase = TRAVERSE_POST;
+        break;
+
+      case TRAVERSE_POST:
+        -- stack.size;
+
+        if (NULL != post_visitor)
+          post_visitor(node, state);
+        break;
+    }
+  }
+
+  traverse_stack_dispose(&stack);
+}
+
+void
+list_tree_traverse_depth(
+    list_tree_node_t *root,
+    list_tree_pre_visitor_t pre_visitor,
+    list_tree_enter_notifier_t descent,
+    list_tree_leave_notifier_t ascent,
+    list_tree_enter_notifier_t forward,
+    list_tree_leave_notifier_t backward,
+    list_tree_post_visitor_t post_visitor,
+    void *state)
+{
+  traverse_depth(
+      root,
+      pre_visitor,
+      descent,
+      ascent,
+      forward,
+      backward,
+      post_visitor,
+      state,
+      0);
+}
+
+void
+list_tree_traverse_prefetch(
+    list_tree_node_t *root,
+    list_tree_pre_visitor_t pre_visitor,
+    list_tree_enter_notifier_t descent,
+    list_tree_leave_notifier_t ascent,
+    list_tree_enter_notifier_t forward,
+    list_tree_leave_notifier_t backward,
+    list_tree_post_visitor_t post_visitor,
+    void *state)
+{
+  traverse_depth(
+      root,
+      pre_visitor,
+      descent,
+      ascent,
+      forward,
+      backward,
+      post_visitor,
+      state,
+      1);
+}
+
+/*
+  Frame of the combined traversal: bundles still active on the
+  node, and those of them that descended to its first child and
+  went forward to its next node, as bit masks.
+*/
+typedef struct _multi_frame_t
+{
+  list_tree_node_t *node;
+  traverse_phase_t phase;
+  uint64_t active;
+  uint64_t descended;
+  uint64_t forwarded;
+} multi_frame_t;
+
+static
+void
+multi_push(
+    multi_frame_t **frames,
+    size_t *size,
+    size_t *capacity,
+    list_tree_node_t *node,
+    uint64_t active)
+{
+  if (*size == *capacity)
+  {
+    *capacity *= 2;
+    *frames = (multi_frame_t*) realloc(
+        *frames,
+        *capacity * sizeof(multi_frame_t));
+
+    assert(NULL != *frames);
+  }
+
+  multi_frame_t *frame = &(*frames)[(*size) ++];
+
+  frame->node = node;
+  frame->phase = TRAVERSE_PRE;
+  frame->active = active;
+  frame->descended = 0;
+  frame->forwarded = 0;
+}
+
+/* Call an enter notifier of each bundle in the mask, return those agreeing */
+static
+uint64_t
+multi_enter(
+    list_tree_visitor_bundle_t const* bundles,
+    uint64_t mask,
+    size_t offset)
+{
+  uint64_t result = 0;
 
-  tree->next = *first;
-  *first = tree;
+  for (; 0 != mask; mask &= mask - 1)
+  {
+    size_t i = __builtin_ctzll(mask);
+    list_tree_enter_notifier_t notifier = *(list_tree_enter_notifier_t const*)
+      ((char const*) &bundles[i] + offset);
+
+    if (NULL == notifier || notifier(bundles[i].state))
+      result |= (uint64_t) 1 << i;
+  }
+
+  return result;
 }
 
+static
 void
-list_tree_append(
-    list_tree_node_t *last,
-    list_tree_node_t *appendant)
+multi_leave(
+    list_tree_visitor_bundle_t const* bundles,
+    uint64_t mask,
+    size_t offset)
 {
-  assert(NULL != last);
-  assert(NULL == last->next);
+  for (; 0 != mask; mask &= mask - 1)
+  {
+    size_t i = __builtin_ctzll(mask);
+    list_tree_leave_notifier_t notifier = *(list_tree_leave_notifier_t const*)
+      ((char const*) &bundles[i] + offset);
 
-  last->next = appendant;
+    if (NULL != notifier)
+      notifier(bundles[i].state);
+  }
 }
 
-list_tree_node_t*
-list_tree_prepend_child(
-    list_tree_node_t *parent,
-    list_tree_node_t *new_child)
+/*
+  The phases are those of list_tree_traverse_depth, each applied
+  to the bundles active in the frame.  A frame is reused for the
+  next node as long as no active bundle needs to come back.
+*/
+void
+list_tree_traverse_multi(
+    list_tree_node_t *root,
+    list_tree_visitor_bundle_t const* bundles,
+    size_t bundle_count)
 {
-  list_tree_prepend(
-      &parent->first_child,
-      new_child);
+  assert(bundle_count <= LIST_TREE_MAX_BUNDLES);
 
-  return new_child;
+  if (NULL == root || 0 == bundle_count)
+    return;
+
+  uint64_t all = LIST_TREE_MAX_BUNDLES == bundle_count
+    ? ~(uint64_t) 0
+    : ((uint64_t) 1 << bundle_count) - 1;
+  uint64_t returning = 0;
+
+  for (size_t i = 0; i < bundle_count; ++i)
+  {
+    if (NULL != bundles[i].backward || NULL != bundles[i].post_visitor)
+      returning |= (uint64_t) 1 << i;
+  }
+
+  size_t size = 0;
+  size_t capacity = TRAVERSE_STACK_RESERVE;
+  multi_frame_t *frames = (multi_frame_t*) malloc(
+      capacity * sizeof(multi_frame_t));
+
+  assert(NULL != frames);
+
+  multi_push(&frames, &size, &capacity, root, all);
+
+  while (0 != size)
+  {
+    multi_frame_t *frame = &frames[size - 1];
+    list_tree_node_t *node = frame->node;
+    list_tree_node_t *first_child;
+    list_tree_node_t *next;
+    uint64_t mask;
+
+    switch (frame->phase)
+    {
+      case TRAVERSE_PRE:
+        for (mask = frame->active; 0 != mask; mask &= mask - 1)
+        {
+          size_t i = __builtin_ctzll(mask);
+          list_tree_pre_visitor_t pre_visitor = bundles[i].pre_visitor;
+
+          if (NULL != pre_visitor && !pre_visitor(node, bundles[i].state))
+            frame->active &= ~((uint64_t) 1 << i);
+        }
+
+        if (0 == frame->active)
+        {
+          -- size;
+          break;
+        }
+
+        frame->phase = TRAVERSE_ASCENT;
+        first_child = list_tree_node_first_child(node);
+
+        if (NULL != first_child)
+        {
+          frame->descended = multi_enter(
+              bundles,
+              frame->active,
+              offsetof(list_tree_visitor_bundle_t, descent));
+
+          if (0 != frame->descended)
+            multi_push(&frames, &size, &capacity, first_child, frame->descended);
+        }
+        break;
+
+      case TRAVERSE_ASCENT:
+        multi_leave(
+            bundles,
+            frame->descended,
+            offsetof(list_tree_visitor_bundle_t, ascent));
+
+        frame->phase = TRAVERSE_BACKWARD;
+        next = list_tree_node_next(node);
+
+        if (NULL == next)
+          break;
+
+        frame->forwarded = multi_enter(
+            bundles,
+            frame->active,
+            offsetof(list_tree_visitor_bundle_t, forward));
+
+        if (0 == frame->forwarded)
+          break;
+
+        if (0 == (frame->active & returning))
+        {
+          frame->node = next;
+          frame->phase = TRAVERSE_PRE;
+          frame->active = frame->forwarded;
+          frame->descended = 0;
+          frame->forwarded = 0;
+        }
+        else
+        {
+          multi_push(&frames, &size, &capacity, next, frame->forwarded);
+        }
+        break;
+
+      case TRAVERSE_BACKWARD:
+        multi_leave(
+            bundles,
+            frame->forwarded,
+            offsetof(list_tree_visitor_bundle_t, backward));
+
+        -- size;
+
+        for (mask = frame->active; 0 != mask; mask &= mask - 1)
+        {
+          size_t i = __builtin_ctzll(mask);
+
+          if (NULL != bundles[i].post_visitor)
+            bundles[i].post_visitor(node, bundles[i].state);
+        }
+        break;
+
+      default:
+        assert(0);
+        break;
+    }
+  }
+
+  free(frames);
 }
 
-typedef struct _dispose_state_t
+enum { QUEUE_INITIAL_CAPACITY = 64 };
+
+/*
+  Ring buffer of the heads of lists waiting to be visited.  The
+  capacity is a power of 2, so positions wrap around by masking.
+*/
+struct _list_tree_queue_t
 {
-  data_disposer_t disposer;
-} dispose_state_t;
+  list_tree_node_t **heads;
+  size_t first;
+  size_t size;
+  size_t capacity;
+};
 
-static
-void
-list_tree_dispose_post_visitor(
-      list_tree_node_t *node,
-      void *raw_state)
+list_tree_queue_t*
+list_tree_queue_create(void)
 {
-  assert(NULL != raw_state);
+  list_tree_queue_t *queue =
+    (list_tree_queue_t*) malloc(sizeof(list_tree_queue_t));
 
-  dispose_state_t *state = (dispose_state_t*) raw_state;
-  data_disposer_t disposer = state->disposer;
-  
-  if (NULL != disposer)
-    disposer(node->data);
+  assert(NULL != queue);
 
-  free(node);
+  queue->heads = NULL;
+  queue->first = 0;
+  queue->size = 0;
+  queue->capacity = 0;
+
+  return queue;
 }
-    
+
 void
-list_tree_dispose(
-    list_tree_node_t *root,
-    data_disposer_t data_disposer)
+list_tree_queue_dispose(
+    list_tree_queue_t *queue)
 {
-  dispose_state_t state = {data_disposer};
+  assert(NULL != queue);
 
-  list_tree_traverse_depth(
-      root,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      list_tree_dispose_post_visitor,
-      &state);
+  free(queue->heads);
+  free(queue);
 }
 
 static
 void
-list_tree_traverse_subtree(
-    list_tree_node_t *node,
-    list_tree_enter_notifier_t enter,
-    list_tree_leave_notifier_t leave,
-    list_tree_pre_visitor_t pre_visitor,
-    list_tree_enter_notifier_t descent,
-    list_tree_leave_notifier_t ascent,
-    list_tree_enter_notifier_t forward,
-    list_tree_leave_notifier_t backward,
-    list_tree_post_visitor_t post_visitor,
-    void *state)
+queue_push(
+    list_tree_queue_t *queue,
+    list_tree_node_t *head)
 {
-  if (NULL == node)
-    return;
-
-  if ((NULL == enter) || enter(state))
+  if (queue->size == queue->capacity)
   {
-    list_tree_traverse_depth(
-        node,
-        pre_visitor,
-        descent,
-        ascent,
-        forward,
-        backward,
-        post_visitor,
-        state);
-
-    if (NULL != leave)
-      leave(state);
+    size_t capacity = 0 == queue->capacity
+      ? QUEUE_INITIAL_CAPACITY
+      : 2 * queue->capacity;
+
+    queue->heads = (list_tree_node_t**) realloc(
+        queue->heads,
+        capacity * sizeof(list_tree_node_t*));
+
+    assert(NULL != queue->heads);
+
+    /* Move the wrapped part to the end of the old capacity */
+    size_t wrapped = queue->first + queue->size > queue->capacity
+      ? queue->first + queue->size - queue->capacity
+      : 0;
+
+    memcpy(
+        queue->heads + queue->capacity,
+        queue->heads,
+        wrapped * sizeof(list_tree_node_t*));
+
+    queue->capacity = capacity;
   }
+
+  queue->heads[(queue->first + queue->size) & (queue->capacity - 1)] = head;
+  ++ queue->size;
+}
+
+static
+list_tree_node_t*
+queue_pop(
+    list_tree_queue_t *queue)
+{
+  list_tree_node_t *head = queue->heads[queue->first];
+
+  queue->first = (queue->first + 1) & (queue->capacity - 1);
+  -- queue->size;
+
+  return head;
 }
 
+/*
+  The queue holds heads of lists rather than single nodes, so
+  that every node is reached through the next link of its previous
+  sibling and only lists that have nodes take a place in it.  The
+  lists of a level are exactly those queued while visiting the
+  previous one.
+*/
 void
-list_tree_traverse_depth(
+list_tree_traverse_breadth(
     list_tree_node_t *root,
-    list_tree_pre_visitor_t pre_visitor,
-    list_tree_enter_notifier_t descent,
-    list_tree_leave_notifier_t ascent,
-    list_tree_enter_notifier_t forward,
-    list_tree_leave_notifier_t backward,
-    list_tree_post_visitor_t post_visitor,
+    list_tree_queue_t *queue,
+    list_tree_level_begin_t level_begin,
+    list_tree_pre_visitor_t visitor,
+    list_tree_level_end_t level_end,
     void *state)
 {
   if (NULL == root)
     return;
 
-  if ((NULL == pre_visitor) || pre_visitor(root, state))
+  list_tree_queue_t *own_queue = NULL;
+
+  if (NULL == queue)
+    queue = own_queue = list_tree_queue_create();
+
+  queue->first = 0;
+  queue->size = 0;
+  queue_push(queue, root);
+
+  int is_stopped = 0;
+
+  for (size_t depth = 0; !is_stopped && 0 != queue->size; ++ depth)
   {
-    list_tree_traverse_subtree(
-        root->first_child,
-        descent,
-        ascent,
-        pre_visitor,
-        descent,
-        ascent,
-        forward,
-        backward,
-        post_visitor,
-        state);
-
-    list_tree_traverse_subtree(
-        root->next,
-        forward,
-        backward,
-        pre_visitor,
-        descent,
-        ascent,
-        forward,
-        backward,
-        post_visitor,
-        state);
-
-    if (NULL != post_visitor)
-      post_visitor(root, state);
+    if ((NULL != level_begin) && !level_begin(depth, state))
+      break;
+
+    for (size_t lists = queue->size; !is_stopped && 0 != lists; -- lists)
+    {
+      list_tree_node_t *node = queue_pop(queue);
+
+      for (; !is_stopped && NULL != node; node = list_tree_node_next(node))
+      {
+        int action = NULL == visitor ? 1 : visitor(node, state);
+        list_tree_node_t *first_child =
+          0 < action ? list_tree_node_first_child(node) : NULL;
+
+        if (NULL != first_child)
+          queue_push(queue, first_child);
+
+        is_stopped = action < 0;
+      }
+    }
+
+    if (!is_stopped && NULL != level_end)
+      level_end(depth, state);
   }
+
+  queue->size = 0;
+
+  if (NULL != own_queue)
+    list_tree_queue_dispose(own_queue);
 }
 
 int
@@ -299,15 +1291,14 @@ list_tree_node_counter(
 static
 size_t
 list_tree_count_nodes(
-    list_tree_node_t *root,
-    list_tree_enter_notifier_t descent)
+    list_tree_node_t *root)
 {
   size_t count = 0;
 
   list_tree_traverse_depth(
       root,
       list_tree_node_counter,
-      descent,
+      NULL,
       NULL,
       NULL,
       NULL,
@@ -321,14 +1312,31 @@ size_t
 list_tree_size(
     list_tree_node_t *root)
 {
-  return list_tree_count_nodes(root, NULL);
+  if (!is_augmented(root))
+    return list_tree_count_nodes(root);
+
+  if (augmented_list_of(root)->first == root)
+    return augmented_list_of(root)->size;
+
+  size_t size = 0;
+
+  for (list_tree_node_t *node = root; NULL != node; node = node->next)
+    size += list_tree_augment_of(node)->size;
+
+  return size;
 }
 
+/* Children are not looked at, which keeps lazy trees from growing */
 size_t
 list_tree_length(
     list_tree_node_t *root)
 {
-  return list_tree_count_nodes(root, enter_false);
+  size_t length = 0;
+
+  for (list_tree_node_t *node = root; NULL != node; node = list_tree_node_next(node))
+    ++ length;
+
+  return length;
 }
 
 typedef struct _depth_counter_t
@@ -375,6 +1383,22 @@ list_tree_depth(
   if (NULL == root)
     return 0;
 
+  if (is_augmented(root))
+  {
+    if (augmented_list_of(root)->first == root)
+      return augmented_list_of(root)->height;
+
+    size_t height = 0;
+
+    for (list_tree_node_t *node = root; NULL != node; node = node->next)
+    {
+      if (height < list_tree_augment_of(node)->height)
+        height = list_tree_augment_of(node)->height;
+    }
+
+    return height;
+  }
+
   depth_counter_t state = { 0, 0 };
 
   list_tree_traverse_depth(
@@ -390,6 +1414,88 @@ list_tree_depth(
   return state.max_depth + 1;
 }
 
+typedef struct _nth_state_t
+{
+  size_t index;
+  list_tree_node_t *result;
+} nth_state_t;
+
+static
+int
+list_tree_nth_pre_visitor(
+    list_tree_node_t *node,
+    void *raw_state)
+{
+  assert(NULL != raw_state);
+
+  nth_state_t *state = (nth_state_t*) raw_state;
+
+  if (NULL != state->result)
+    return 0;
+
+  if (0 == state->index)
+  {
+    state->result = node;
+    return 0;
+  }
+
+  -- state->index;
+
+  return 1;
+}
+
+/*
+  With metadata, the subtree of the first child is skipped as a
+  whole whenever the node sought is not in it, so only the nodes
+  on the way to the result are visited.
+*/
+list_tree_node_t*
+list_tree_nth(
+    list_tree_node_t *root,
+    size_t index)
+{
+  if (!is_augmented(root))
+  {
+    nth_state_t state = { index, NULL };
+
+    list_tree_traverse_depth(
+        root,
+        list_tree_nth_pre_visitor,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        &state);
+
+    return state.result;
+  }
+
+  list_tree_node_t *node = root;
+
+  while (NULL != node)
+  {
+    size_t size = list_tree_augment_of(node)->size;
+
+    if (index >= size)
+    {
+      index -= size;
+      node = node->next;
+    }
+    else if (0 == index)
+    {
+      break;
+    }
+    else
+    {
+      -- index;
+      node = node->first_child;
+    }
+  }
+
+  return node;
+}
+
 typedef struct _find_state_t
 {
   predicate_t predicate;
@@ -448,134 +1554,77 @@ list_tree_find(
   return state.result;
 }
 
-typedef struct _locate_state_t
-{
-  size_t const* path;
-  size_t path_length;
-  size_t count;
-  list_tree_node_t *result;
-} locate_state_t;
-
-static
-int
-list_tree_node_locate_pre_visitor(
-    list_tree_node_t* node,
-    void *raw_state)
-{
-  assert(NULL != raw_state);
-
-  locate_state_t *state = (locate_state_t*) raw_state;
-
-  assert(0 <= state->path_length);
-  assert(NULL == state->result);
-  assert(state->count <= *state->path);
-  
-  if (state->count == *state->path && 1 == state->path_length)
-  {
-    state->result = node;
-    return 0;
-  }
-  
-  return 1;
-}
-
 static
 int
-list_tree_node_locate_descent(
-    void *raw_state)
-{
-  assert(NULL != raw_state);
-
-  locate_state_t *state = (locate_state_t*) raw_state;
-
-  if (NULL != state->result || state->count != *state->path)
-    return 0;
-  
-  assert(1 < state->path_length);
-
-  state->count = 0;
-  ++ state->path;
-  -- state->path_length;
-
-  return 1;
-}
-
-static
-void
-list_tree_node_locate_ascent(
+list_tree_node_find_nearest_visitor(
+    list_tree_node_t *node,
     void *raw_state)
 {
   assert(NULL != raw_state);
 
-  locate_state_t *state = (locate_state_t*) raw_state;
-
-  assert(0 == state->count);
-  
-  ++ state->path_length;
-  -- state->path;
-  state->count = *state->path;
-}
-
-static
-int
-list_tree_node_locate_forward(
-    void *raw_state)
-{
-  assert(NULL != raw_state);
+  find_state_t *state = (find_state_t*) raw_state;
 
-  locate_state_t *state = (locate_state_t*) raw_state;
+  assert(NULL != state->predicate);
 
-  if (NULL != state->result || state->count >= *state->path)
-    return 0;
-  
-  ++ state->count;
+  if (!state->predicate(node->data, state->predicate_param))
+    return 1;
 
-  return 1;
+  state->result = node;
+  return -1;
 }
 
-static
-void
-list_tree_node_locate_backward(
-    void *raw_state)
+list_tree_node_t*
+list_tree_find_nearest(
+    list_tree_node_t *root,
+    predicate_t predicate,
+    void *predicate_param)
 {
-  assert(NULL != raw_state);
+  find_state_t state =
+  {
+    predicate,
+    predicate_param,
+    NULL
+  };
 
-  locate_state_t *state = (locate_state_t*) raw_state;
+  list_tree_traverse_breadth(
+      root,
+      NULL,
+      NULL,
+      list_tree_node_find_nearest_visitor,
+      NULL,
+      &state);
 
-  assert(0 < state->count);
-  
-  -- state->count;
+  return state.result;
 }
 
+/*
+  Walking the path directly visits exactly the nodes it goes
+  through: the preceding siblings and the first child on each
+  level.
+*/
 list_tree_node_t*
 list_tree_locate(
     list_tree_node_t *root,
     size_t const* path,
     size_t path_length)
 {
-  locate_state_t state =
+  if (0 == path_length)
+    return NULL;
+
+  list_tree_node_t *node = root;
+
+  for (size_t level = 0; NULL != node; ++level)
   {
-    path,
-    path_length,
-    0,
-    NULL
-  };
+    for (size_t i = path[level]; 0 != i && NULL != node; --i)
+      node = list_tree_node_next(node);
 
-  list_tree_traverse_depth(
-      root,
-      list_tree_node_locate_pre_visitor,
-      list_tree_node_locate_descent,
-      list_tree_node_locate_ascent,
-      list_tree_node_locate_forward,
-      list_tree_node_locate_backward,
-      NULL,
-      &state);
+    if (NULL == node || level + 1 == path_length)
+      break;
 
-  assert(state.path_length == path_length);
-  assert(state.path == path);
-  assert(state.count == 0);
+    node = list_tree_node_first_child(node);
+  }
 
-  return state.result;
+  return node;
 }
 
 typedef struct _write_state_t
@@ -39,6 +39,10 @@ typedef struct _path_item_t
   struct _path_item_t const* prev;
 } path_item_t;
 
+/*
+  Callback to produce data of the node at the given path.  Returns
+  false (0) if there is no such node, i.e. the list ends before it.
+*/
 typedef
   int
   (*node_generator_t)(
@@ -46,6 +50,30 @@ typedef
       void *state,
       void **data);
 
+/*
+  Where an extended generator is called: the path, the depth of
+  the node (0 in the root list), its index in its list, the data
+  generated for its parent (NULL in the root list), and a slot
+  for the generator's own use, shared by all nodes of the list
+  and set to NULL before its first node.  The scratch slot and
+  the path are only valid during the call.
+*/
+typedef struct _generator_context_t
+{
+  path_item_t const* path;
+  size_t depth;
+  size_t index;
+  void *parent_data;
+  void **scratch;
+} generator_context_t;
+
+typedef
+  int
+  (*node_generator_ex_t)(
+      generator_context_t const* context,
+      void *state,
+      void **data);
+
 /* Callback before visiting a subtree */
 typedef
   int
@@ -72,6 +100,25 @@ typedef
   (*list_tree_leave_notifier_t)(
       void *state);
 
+/* Callback before visiting a level of a tree */
+typedef
+  int
+  (*list_tree_level_begin_t)(
+      size_t depth,
+      void *state);
+
+/* Callback after visiting a level of a tree */
+typedef
+  void
+  (*list_tree_level_end_t)(
+      size_t depth,
+      void *state);
+
+/* Queue of the breadth-first traversal, see below */
+typedef
+  struct _list_tree_queue_t
+  list_tree_queue_t;
+
 /* Callback to dispose data stored in a node */
 typedef
   void
@@ -85,6 +132,12 @@ typedef
       void const* data,
       void const* param);
 
+/* Callback to hash node data, see list_tree_hash.h */
+typedef
+  size_t
+  (*data_hasher_t)(
+      void const* data);
+
 /* Callback to write node data to a file */
 typedef
 int (*data_writer_t)(
@@ -115,11 +168,69 @@ list_tree_make(
     list_tree_node_t *next,
     list_tree_node_t *first_child);
 
+/*
+  Build a tree calling the generator for each node in depth-first
+  order, and for the position right after the last node of each
+  list.  The generation is iterative, so neither depth nor length
+  of lists is limited by the call stack.
+*/
 list_tree_node_t*
 list_tree_generate(
     node_generator_t generator,
     void *state);
 
+/* Same with an extended generator, called in the same order */
+list_tree_node_t*
+list_tree_generate_ex(
+    node_generator_ex_t generator,
+    void *state);
+
+/*
+  Augmented nodes additionally keep the size and the depth of the
+  subtree below them, and each augmented list keeps those of the
+  whole list and a link to its parent.  The modifiers below keep
+  this metadata up to date at the cost of O(depth of the change),
+  plus the length of the list added by list_tree_append.  For the
+  first node of a list, list_tree_size and list_tree_depth cost
+  O(1), otherwise the rest of the list is walked; list_tree_nth
+  costs O(length of the path to the result), i.e. it walks each
+  list down to the result rather than searching it.
+
+  Augmented and ordinary nodes must not be linked together, and
+  next and first_child passed to the constructor must not be
+  linked from other nodes yet.  To add the first child of an
+  augmented node, use list_tree_prepend_child rather than
+  list_tree_prepend, which cannot tell the parent of an empty list.
+*/
+list_tree_node_t*
+list_tree_make_augmented(
+    void *data,
+    list_tree_node_t *next,
+    list_tree_node_t *first_child);
+
+/*
+  Inline nodes keep a payload of payload_size bytes right after
+  their links, in the same block of memory, instead of pointing
+  to data allocated elsewhere.  The payload is copied from the
+  given buffer, or filled with zeros if it is NULL, and is aligned
+  as a pointer.  The data of an inline node, e.g. as passed to
+  predicates and writers, is the address of its payload.
+
+  Payloads are freed together with their nodes, so data disposers
+  are not called on them.
+*/
+list_tree_node_t*
+list_tree_make_inline(
+    void const* payload,
+    size_t payload_size,
+    list_tree_node_t *next,
+    list_tree_node_t *first_child);
+
+/* Address of the payload of an inline node */
+void*
+list_tree_get_payload(
+    list_tree_node_t *node);
+
 /* Modifiers */
 void
 list_tree_prepend(
@@ -136,7 +247,28 @@ list_tree_prepend_child(
     list_tree_node_t *parent,
     list_tree_node_t *new_child);
 
-/* Destructor */
+/*
+  Same as list_tree_prepend and list_tree_prepend_child, but safe
+  to call from several threads inserting into the same or
+  different lists, and concurrently with readers using the
+  getters, traversals and other read-only functions.  The new
+  node is linked with an atomic compare-and-swap and becomes
+  visible to readers only when it is fully initialised.
+
+  Nodes must not be augmented, and the tree must not be modified
+  otherwise or disposed while the insertions are running.
+*/
+void
+list_tree_prepend_concurrent(
+    list_tree_node_t **first,
+    list_tree_node_t *tree);
+
+list_tree_node_t*
+list_tree_prepend_child_concurrent(
+    list_tree_node_t *parent,
+    list_tree_node_t *new_child);
+
+/* Destructor; uses no memory besides the tree, whatever its shape */
 void
 list_tree_dispose(
     list_tree_node_t *root,
@@ -171,6 +303,12 @@ list_tree_dispose(
   Each callback has a state parameter that is a buffer with
   application-specific data. Callbacks are responsible for
   interpreting, processing and modifying the state correctly.
+
+  The traversal is not recursive: it keeps an explicit stack on
+  the heap, so the call stack does not grow with the size of the
+  tree.  When both backward and post_visitor are NULL, the stack
+  grows with the depth of the tree only, regardless of the length
+  of any list.
 */
 void
 list_tree_traverse_depth(
@@ -183,6 +321,94 @@ list_tree_traverse_depth(
     list_tree_post_visitor_t post_visitor,
     void *state);
 
+/*
+  Same as list_tree_traverse_depth, but on descending to the
+  children of a node, its next node is prefetched into the cache,
+  so that fetching it overlaps with visiting the children.  Pays
+  off on trees whose nodes are scattered over the heap and have
+  subtrees large enough to hide the latency; on a compacted tree
+  (see list_tree_arena_compact) the hardware prefetcher already
+  does better.
+*/
+void
+list_tree_traverse_prefetch(
+    list_tree_node_t *root,
+    list_tree_pre_visitor_t pre_visitor,
+    list_tree_enter_notifier_t descent,
+    list_tree_leave_notifier_t ascent,
+    list_tree_enter_notifier_t forward,
+    list_tree_leave_notifier_t backward,
+    list_tree_post_visitor_t post_visitor,
+    void *state);
+
+/*
+  A set of callbacks of list_tree_traverse_depth with their state.
+*/
+typedef struct _list_tree_visitor_bundle_t
+{
+  list_tree_pre_visitor_t pre_visitor;
+  list_tree_enter_notifier_t descent;
+  list_tree_leave_notifier_t ascent;
+  list_tree_enter_notifier_t forward;
+  list_tree_leave_notifier_t backward;
+  list_tree_post_visitor_t post_visitor;
+  void *state;
+} list_tree_visitor_bundle_t;
+
+enum { LIST_TREE_MAX_BUNDLES = 64 };
+
+/*
+  Run up to LIST_TREE_MAX_BUNDLES traversals in a single walk over
+  the tree.  Each bundle gets exactly the calls it would get from
+  list_tree_traverse_depth on its own, including pruning: when a
+  callback of a bundle returns false, only that bundle skips the
+  corresponding part of the tree.  The walk itself skips a part
+  when all bundles do.  At each step, the bundles are called in
+  the order they are given.
+*/
+void
+list_tree_traverse_multi(
+    list_tree_node_t *root,
+    list_tree_visitor_bundle_t const* bundles,
+    size_t bundle_count);
+
+/*
+  Traverse a list-tree level by level, each level from left to
+  right, invoking user-specified call-backs:
+  - level_begin before the first node of a level; if it returns
+    false (0), the traversal stops;
+  - visitor on each node of the level; it returns:
+    - positive: continue, visiting the children of the node on
+      the next level;
+    - 0: continue, skipping the subtree of the node;
+    - negative: stop the traversal at once;
+  - level_end after the last node of a level, unless the
+    traversal has been stopped by the visitor.
+
+  Each callback can be NULL, which is equivalent to a function
+  that returns 1 where a value is expected.
+
+  Lists yet to be visited are kept in the queue, which grows to
+  the number of non-empty lists on the widest level.  A queue
+  passed by the caller keeps its memory between traversals; if
+  the queue is NULL, a temporary one is used.
+*/
+void
+list_tree_traverse_breadth(
+    list_tree_node_t *root,
+    list_tree_queue_t *queue,
+    list_tree_level_begin_t level_begin,
+    list_tree_pre_visitor_t visitor,
+    list_tree_level_end_t level_end,
+    void *state);
+
+list_tree_queue_t*
+list_tree_queue_create(void);
+
+void
+list_tree_queue_dispose(
+    list_tree_queue_t *queue);
+
 int
 enter_false(
     void *);
@@ -200,12 +426,29 @@ size_t
 list_tree_depth(
     list_tree_node_t *root);
 
+/* Return the node at the index in depth-first order, or NULL */
+list_tree_node_t*
+list_tree_nth(
+    list_tree_node_t *root,
+    size_t index);
+
 list_tree_node_t*
 list_tree_find(
     list_tree_node_t *root,
     predicate_t predicate,
     void *predicate_param);
 
+/*
+  Same as list_tree_find, but return a matching node of the least
+  depth, the leftmost on its level.  Deeper levels are not visited
+  once a match is found.
+*/
+list_tree_node_t*
+list_tree_find_nearest(
+    list_tree_node_t *root,
+    predicate_t predicate,
+    void *predicate_param);
+
 list_tree_node_t*
 list_tree_locate(
     list_tree_node_t *root,
@@ -0,0 +1,330 @@
+/*
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include "list_tree.h"
+#include "list_tree_arena.h"
+#include "list_tree_node.h"
+
+enum { ARENA_DEFAULT_SLAB_LENGTH = 4096 };
+
+typedef struct _arena_slab_t
+{
+  struct _arena_slab_t *prev;
+  size_t used;
+  size_t capacity;
+  list_tree_node_t nodes[];
+} arena_slab_t;
+
+/*
+  Nodes of an inline arena are payload_size bytes longer, so they
+  are placed stride bytes apart rather than as array elements.
+*/
+struct _list_tree_arena_t
+{
+  arena_slab_t *current;
+  size_t slab_length;
+  size_t count;
+  size_t payload_size;
+  size_t stride;
+};
+
+list_tree_arena_t*
+list_tree_arena_create(
+    size_t slab_length)
+{
+  list_tree_arena_t *arena =
+    (list_tree_arena_t*) malloc(sizeof(list_tree_arena_t));
+
+  assert(NULL != arena);
+
+  arena->current = NULL;
+  arena->slab_length =
+    0 == slab_length ? ARENA_DEFAULT_SLAB_LENGTH : slab_length;
+  arena->count = 0;
+  arena->payload_size = 0;
+  arena->stride = sizeof(list_tree_node_t);
+
+  return arena;
+}
+
+list_tree_arena_t*
+list_tree_arena_create_inline(
+    size_t slab_length,
+    size_t payload_size)
+{
+  list_tree_arena_t *arena = list_tree_arena_create(slab_length);
+
+  arena->payload_size = payload_size;
+  arena->stride = list_tree_inline_size(payload_size);
+
+  return arena;
+}
+
+static
+list_tree_node_t*
+arena_slab_node(
+    list_tree_arena_t const* arena,
+    arena_slab_t *slab,
+    size_t index)
+{
+  return (list_tree_node_t*) ((char*) slab->nodes + index * arena->stride);
+}
+
+void
+list_tree_arena_release(
+    list_tree_arena_t *arena,
+    data_disposer_t data_disposer)
+{
+  assert(NULL != arena);
+
+  arena_slab_t *slab = arena->current;
+
+  while (NULL != slab)
+  {
+    arena_slab_t *prev = slab->prev;
+
+    if (NULL != data_disposer)
+    {
+      for (size_t i = 0; i < slab->used; ++i)
+      {
+        list_tree_node_t *node = arena_slab_node(arena, slab, i);
+
+        if (0 == (node->flags & NODE_INLINE))
+          data_disposer(node->data);
+      }
+    }
+
+    free(slab);
+    slab = prev;
+  }
+
+  free(arena);
+}
+
+size_t
+list_tree_arena_payload_size(
+    list_tree_arena_t const* arena)
+{
+  assert(NULL != arena);
+
+  return arena->payload_size;
+}
+
+size_t
+list_tree_arena_count(
+    list_tree_arena_t const* arena)
+{
+  assert(NULL != arena);
+
+  return arena->count;
+}
+
+/*
+  Slabs of the source go below the current slab of the target so
+  that allocation from the target continues where it stopped.
+*/
+void
+list_tree_arena_merge(
+    list_tree_arena_t *target,
+    list_tree_arena_t *source)
+{
+  assert(NULL != target);
+  assert(NULL != source);
+  assert(target->stride == source->stride);
+
+  arena_slab_t *first = source->current;
+
+  if (NULL != first)
+  {
+    arena_slab_t *last = first;
+
+    while (NULL != last->prev)
+      last = last->prev;
+
+    if (NULL == target->current)
+    {
+      target->current = first;
+    }
+    else
+    {
+      last->prev = target->current->prev;
+      target->current->prev = first;
+    }
+  }
+
+  target->count += source->count;
+
+  free(source);
+}
+
+/*
+  Make sure the current slab has room for count more nodes, so
+  that they are allocated next to each other.  A slab that is too
+  short is left partly unused.
+*/
+static
+void
+list_tree_arena_reserve(
+    list_tree_arena_t *arena,
+    size_t count)
+{
+  arena_slab_t *slab = arena->current;
+
+  if (NULL == slab || slab->capacity - slab->used < count)
+  {
+    size_t capacity =
+      count > arena->slab_length ? count : arena->slab_length;
+
+    slab = (arena_slab_t*) malloc(
+        sizeof(arena_slab_t) +
+        capacity * arena->stride);
+
+    assert(NULL != slab);
+
+    slab->prev = arena->current;
+    slab->used = 0;
+    slab->capacity = capacity;
+    arena->current = slab;
+  }
+}
+
+static
+list_tree_node_t*
+list_tree_arena_alloc(
+    list_tree_arena_t *arena)
+{
+  list_tree_arena_reserve(arena, 1);
+
+  arena_slab_t *slab = arena->current;
+
+  ++ arena->count;
+
+  return arena_slab_node(arena, slab, slab->used ++);
+}
+
+list_tree_node_t*
+list_tree_arena_make_singleton(
+    list_tree_arena_t *arena,
+    void *data)
+{
+  return list_tree_arena_make(arena, data, NULL, NULL);
+}
+
+list_tree_node_t*
+list_tree_arena_make(
+    list_tree_arena_t *arena,
+    void *data,
+    list_tree_node_t *next,
+    list_tree_node_t *first_child)
+{
+  list_tree_node_t *node = NULL == arena
+    ? (list_tree_node_t*) malloc(sizeof(list_tree_node_t))
+    : list_tree_arena_alloc(arena);
+
+  node->data = data;
+  node->next = next;
+  node->first_child = first_child;
+  node->flags = NULL == arena ? 0 : NODE_ARENA;
+
+  return node;
+}
+
+list_tree_node_t*
+list_tree_arena_make_inline(
+    list_tree_arena_t *arena,
+    void const* payload,
+    list_tree_node_t *next,
+    list_tree_node_t *first_child)
+{
+  assert(NULL != arena);
+
+  list_tree_node_t *node = list_tree_inline_init(
+      list_tree_arena_alloc(arena),
+      payload,
+      arena->payload_size,
+      next,
+      first_child);
+
+  node->flags |= NODE_ARENA;
+
+  return node;
+}
+
+/* A node of the old tree and the link of the new tree to point to its copy */
+typedef struct _compact_frame_t
+{
+  list_tree_node_t *node;
+  list_tree_node_t **link;
+} compact_frame_t;
+
+/*
+  Pending next nodes are kept on a stack under the first child,
+  so that the copies come out in depth-first order and the stack
+  grows with the depth of the tree only.  Each old node is freed
+  as soon as it is copied.
+*/
+void
+list_tree_arena_compact(
+    list_tree_arena_t *arena,
+    list_tree_node_t **root)
+{
+  assert(NULL != arena);
+  assert(0 == arena->payload_size);
+  assert(NULL != root);
+
+  if (NULL == *root)
+    return;
+
+  list_tree_arena_reserve(arena, list_tree_size(*root));
+
+  size_t capacity = 16;
+  size_t size = 1;
+  compact_frame_t *frames =
+    (compact_frame_t*) malloc(capacity * sizeof(compact_frame_t));
+
+  assert(NULL != frames);
+
+  frames[0].node = *root;
+  frames[0].link = root;
+
+  while (0 != size)
+  {
+    compact_frame_t frame = frames[-- size];
+    list_tree_node_t *node = frame.node;
+
+    assert(0 == node->flags);
+
+    if (capacity - size < 2)
+    {
+      capacity *= 2;
+      frames = (compact_frame_t*) realloc(
+          frames,
+          capacity * sizeof(compact_frame_t));
+      assert(NULL != frames);
+    }
+
+    *frame.link = list_tree_arena_make_singleton(arena, node->data);
+
+    if (NULL != node->next)
+    {
+      frames[size].node = node->next;
+      frames[size].link = &(*frame.link)->next;
+      ++ size;
+    }
+
+    if (NULL != node->first_child)
+    {
+      frames[size].node = node->first_child;
+      frames[size].link = &(*frame.link)->first_child;
+      ++ size;
+    }
+
+    free(node);
+  }
+
+  free(frames);
+}
@@ -0,0 +1,128 @@
+/*
+   Arena allocation of list-tree nodes.
+
+   An arena hands out nodes from large slabs instead of calling
+   malloc for every node, and releases all of them at once.  Nodes
+   allocated from an arena belong to the arena: they may be linked
+   with each other and passed to any read-only or modifying
+   function of list_tree.h, but must never be passed to
+   list_tree_dispose.  They are freed only by list_tree_arena_release.
+
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#ifndef _LIST_TREE_ARENA_H_
+#define _LIST_TREE_ARENA_H_
+
+#include "list_tree.h"
+
+typedef
+  struct _list_tree_arena_t
+  list_tree_arena_t;
+
+/*
+  Create an empty arena.  Slab_length is the number of nodes
+  allocated from the system at once; 0 selects a default.
+*/
+list_tree_arena_t*
+list_tree_arena_create(
+    size_t slab_length);
+
+/*
+  Create an empty arena whose nodes all have room for an inline
+  payload of payload_size bytes, see list_tree_make_inline.
+*/
+list_tree_arena_t*
+list_tree_arena_create_inline(
+    size_t slab_length,
+    size_t payload_size);
+
+/*
+  Free all nodes allocated from the arena, and the arena itself.
+  If data_disposer is not NULL, it is called on the data of every
+  node ever allocated from the arena, except inline nodes;
+  otherwise the slabs are just freed without visiting the nodes.
+*/
+void
+list_tree_arena_release(
+    list_tree_arena_t *arena,
+    data_disposer_t data_disposer);
+
+/*
+  Move all nodes of the source arena to the target one and free
+  the source.  Both must have the same payload size.  Useful to
+  collect nodes made by several threads, each allocating from its
+  own arena, under a single owner.
+*/
+void
+list_tree_arena_merge(
+    list_tree_arena_t *target,
+    list_tree_arena_t *source);
+
+/*
+  Move the whole tree starting from *root into one contiguous block
+  of the arena, in depth-first order: every node is followed by
+  its first child, and the last node of a subtree by the next node
+  of its root, so that a traversal reads memory sequentially.  The
+  data pointers are kept, the old nodes are freed and *root is set
+  to the new root.  The tree must consist of plain heap-allocated
+  nodes (neither arena, inline, augmented, lazy nor shared ones),
+  and no other pointers to its nodes may be kept by the caller.
+  The arena must have a payload size of 0.  Like any arena nodes,
+  the new ones must not be passed to list_tree_dispose afterwards:
+  they are freed by list_tree_arena_release.  Arena nodes are
+  marked as such, so both misuses fail an assertion.
+*/
+void
+list_tree_arena_compact(
+    list_tree_arena_t *arena,
+    list_tree_node_t **root);
+
+/* Payload size given to list_tree_arena_create_inline, 0 otherwise */
+size_t
+list_tree_arena_payload_size(
+    list_tree_arena_t const* arena);
+
+/* Number of nodes allocated from the arena so far */
+size_t
+list_tree_arena_count(
+    list_tree_arena_t const* arena);
+
+/*
+  Constructors.  They behave like their counterparts from
+  list_tree.h; a NULL arena means the ordinary heap.
+*/
+list_tree_node_t*
+list_tree_arena_make_singleton(
+    list_tree_arena_t *arena,
+    void *data);
+
+list_tree_node_t*
+list_tree_arena_make(
+    list_tree_arena_t *arena,
+    void *data,
+    list_tree_node_t *next,
+    list_tree_node_t *first_child);
+
+/* Inline node with the payload size of the arena, which is not NULL */
+list_tree_node_t*
+list_tree_arena_make_inline(
+    list_tree_arena_t *arena,
+    void const* payload,
+    list_tree_node_t *next,
+    list_tree_node_t *first_child);
+
+list_tree_node_t*
+list_tree_arena_generate(
+    list_tree_arena_t *arena,
+    node_generator_t generator,
+    void *state);
+
+list_tree_node_t*
+list_tree_arena_generate_ex(
+    list_tree_arena_t *arena,
+    node_generator_ex_t generator,
+    void *state);
+
+#endif
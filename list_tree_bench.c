@@ -0,0 +1,664 @@
+/*
+   Benchmark of list-tree operations.
+
+   For each shape of tree and each size from --min to --max nodes
+   (powers of 10), the tree is generated, measured, searched,
+   written to /dev/null and disposed, then generated once more,
+   compacted into an arena and searched, --warmup times without and
+   --repetitions times with timing.  Results are printed to the
+   standard output as CSV (default) or JSON, one record per shape,
+   size and operation, with the best and the median time per node
+   and the throughput at the median.  Output is written with tags
+   rather than indentation, which would make its size quadratic in
+   the depth of the deep shape.
+
+   Usage: list_tree_bench [--min N] [--max N] [--repetitions N]
+                          [--warmup N] [--format csv|json]
+                          [--shapes wide,deep,balanced,skewed,
+                                    random,power_law,file_system]
+
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "list_tree.h"
+#include "list_tree_arena.h"
+#include "list_tree_cursor.h"
+#include "list_tree_stats.h"
+#include "list_tree_test_data_creator.h"
+
+typedef enum _operation_t
+{
+  OPERATION_GENERATE,
+  OPERATION_SIZE,
+  OPERATION_LENGTH,
+  OPERATION_DEPTH,
+  OPERATION_STATS,
+  OPERATION_FIND_HIT,
+  OPERATION_FIND_MISS,
+  OPERATION_CURSOR_FIND_MISS,
+  OPERATION_PREFETCH_FIND_MISS,
+  OPERATION_LOCATE,
+  OPERATION_WRITE,
+  OPERATION_DISPOSE,
+  OPERATION_COMPACT,
+  OPERATION_COMPACT_FIND_MISS,
+  OPERATION_COUNT
+} operation_t;
+
+static char const* const operation_names[OPERATION_COUNT] =
+{
+  "generate",
+  "size",
+  "length",
+  "depth",
+  "stats",
+  "find_hit",
+  "find_miss",
+  "cursor_find_miss",
+  "prefetch_find_miss",
+  "locate",
+  "write",
+  "dispose",
+  "compact",
+  "compact_find_miss"
+};
+
+typedef enum _shape_t
+{
+  SHAPE_WIDE,
+  SHAPE_DEEP,
+  SHAPE_BALANCED,
+  SHAPE_SKEWED,
+  SHAPE_RANDOM,
+  SHAPE_POWER_LAW,
+  SHAPE_FILE_SYSTEM,
+  SHAPE_COUNT
+} shape_t;
+
+static char const* const shape_names[SHAPE_COUNT] =
+{
+  "wide",
+  "deep",
+  "balanced",
+  "skewed",
+  "random",
+  "power_law",
+  "file_system"
+};
+
+enum
+{
+  BALANCED_FAN_OUT = 10,
+  SKEWED_FAN_OUT = 4,
+  SHAPED_MAX_FAN_OUT = 16,
+  SHAPED_MAX_DEPTH = 20,
+  SHAPED_SEED = 1
+};
+
+typedef struct _options_t
+{
+  size_t min_size;
+  size_t max_size;
+  size_t repetitions;
+  size_t warmup;
+  int is_json;
+  int shapes[SHAPE_COUNT];
+} options_t;
+
+typedef struct _shape_state_t
+{
+  shape_t shape;
+  size_t size;
+  size_t max_depth;
+  size_t count;
+} shape_state_t;
+
+static
+size_t
+path_depth(
+    path_item_t const* path)
+{
+  size_t depth = 0;
+
+  for (path = path->prev; NULL != path; path = path->prev)
+    ++ depth;
+
+  return depth;
+}
+
+/*
+  Generators of the shapes, each making exactly size nodes whose
+  data is the number of the node in depth-first order:
+  - wide: a single list;
+  - deep: a chain of first children;
+  - balanced: a complete tree of BALANCED_FAN_OUT, cut at size;
+  - skewed: lists of SKEWED_FAN_OUT where only the first node has
+    children, i.e. a spine with leaves hanging off it.
+  Random, power law and file system shapes come from the test
+  data creator.
+*/
+static
+int
+shape_generator(
+    path_item_t const* path,
+    void *raw_state,
+    void **data)
+{
+  shape_state_t *state = (shape_state_t*) raw_state;
+
+  if (state->count == state->size)
+    return 0;
+
+  int is_existing = 0;
+
+  switch (state->shape)
+  {
+    case SHAPE_WIDE:
+      is_existing = NULL == path->prev;
+      break;
+
+    case SHAPE_DEEP:
+      is_existing = 0 == path->index;
+      break;
+
+    case SHAPE_BALANCED:
+      is_existing =
+        path->index < BALANCED_FAN_OUT &&
+        path_depth(path) < state->max_depth;
+      break;
+
+    case SHAPE_SKEWED:
+      is_existing =
+        path->index < SKEWED_FAN_OUT &&
+        (NULL == path->prev || 0 == path->prev->index);
+      break;
+
+    default:
+      break;
+  }
+
+  if (is_existing)
+    *data = (void*) (long) state->count ++;
+
+  return is_existing;
+}
+
+static
+list_tree_node_t*
+make_shape(
+    shape_t shape,
+    size_t size)
+{
+  tree_shape_params_t params =
+  {
+    TREE_SHAPE_RANDOM,
+    size,
+    SHAPED_MAX_FAN_OUT,
+    SHAPED_MAX_DEPTH,
+    SHAPED_SEED
+  };
+
+  switch (shape)
+  {
+    case SHAPE_RANDOM:
+      return make_shaped_tree(NULL, &params);
+
+    case SHAPE_POWER_LAW:
+      params.shape = TREE_SHAPE_POWER_LAW;
+      return make_shaped_tree(NULL, &params);
+
+    case SHAPE_FILE_SYSTEM:
+      params.shape = TREE_SHAPE_FILE_SYSTEM;
+      return make_shaped_tree(NULL, &params);
+
+    default:
+      break;
+  }
+
+  shape_state_t state = { shape, size, 1, 0 };
+
+  for (size_t capacity = BALANCED_FAN_OUT; capacity < size; )
+  {
+    ++ state.max_depth;
+    capacity = capacity * BALANCED_FAN_OUT + BALANCED_FAN_OUT;
+  }
+
+  return list_tree_generate(shape_generator, &state);
+}
+
+/* Path to the last node of the last list on each level */
+static
+size_t*
+make_last_path(
+    list_tree_node_t *root,
+    size_t *path_length)
+{
+  size_t capacity = 16;
+  size_t *path = (size_t*) malloc(capacity * sizeof(size_t));
+
+  assert(NULL != path);
+
+  *path_length = 0;
+
+  while (NULL != root)
+  {
+    size_t index = 0;
+
+    while (NULL != list_tree_get_next(root))
+    {
+      root = list_tree_get_next(root);
+      ++ index;
+    }
+
+    if (*path_length == capacity)
+    {
+      capacity *= 2;
+      path = (size_t*) realloc(path, capacity * sizeof(size_t));
+
+      assert(NULL != path);
+    }
+
+    path[(*path_length) ++] = index;
+    root = list_tree_get_first_child(root);
+  }
+
+  return path;
+}
+
+static
+int
+long_comparer(
+    void const* data,
+    void const* param)
+{
+  return data == param;
+}
+
+static
+int
+long_writer(
+    FILE *output,
+    void *data)
+{
+  return 0 <= fprintf(output, "%ld\n", (long) data);
+}
+
+static
+double
+now(
+    void)
+{
+  struct timespec time;
+
+  clock_gettime(CLOCK_MONOTONIC, &time);
+
+  return 1e9 * time.tv_sec + time.tv_nsec;
+}
+
+static volatile size_t sink;
+
+/* Same as list_tree_find with long_comparer, as a pre_visitor */
+static
+int
+long_finder(
+    list_tree_node_t *node,
+    void *param)
+{
+  if (list_tree_get_data(node) != param)
+    return 1;
+
+  sink = (size_t) node;
+  return 0;
+}
+
+/* Run all operations once, storing their durations in ns */
+static
+void
+run_round(
+    shape_t shape,
+    size_t size,
+    FILE *null_output,
+    double *durations)
+{
+  double start = now();
+  list_tree_node_t *tree = make_shape(shape, size);
+  durations[OPERATION_GENERATE] = now() - start;
+
+  assert(list_tree_size(tree) == size);
+
+  size_t path_length;
+  size_t *path = make_last_path(tree, &path_length);
+
+  start = now();
+  sink = list_tree_size(tree);
+  durations[OPERATION_SIZE] = now() - start;
+
+  start = now();
+  sink = list_tree_length(tree);
+  durations[OPERATION_LENGTH] = now() - start;
+
+  start = now();
+  sink = list_tree_depth(tree);
+  durations[OPERATION_DEPTH] = now() - start;
+
+  list_tree_stats_t stats;
+
+  start = now();
+  list_tree_stats(tree, &stats);
+  durations[OPERATION_STATS] = now() - start;
+
+  sink = stats.size;
+  list_tree_stats_dispose(&stats);
+
+  start = now();
+  sink = (size_t) list_tree_find(tree, long_comparer, (void*) (long) (size - 1));
+  durations[OPERATION_FIND_HIT] = now() - start;
+
+  start = now();
+  sink = (size_t) list_tree_find(tree, long_comparer, (void*) -1L);
+  durations[OPERATION_FIND_MISS] = now() - start;
+
+  /* The same search as a loop over a cursor, without callbacks */
+  list_tree_cursor_t cursor;
+
+  start = now();
+  list_tree_cursor_init(&cursor, tree);
+  while (list_tree_cursor_next_preorder(&cursor)
+      && -1L != (long) list_tree_get_data(list_tree_cursor_node(&cursor)))
+    ;
+  sink = (size_t) list_tree_cursor_node(&cursor);
+  list_tree_cursor_dispose(&cursor);
+  durations[OPERATION_CURSOR_FIND_MISS] = now() - start;
+
+  start = now();
+  list_tree_traverse_prefetch(
+      tree,
+      long_finder,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      (void*) -1L);
+  durations[OPERATION_PREFETCH_FIND_MISS] = now() - start;
+
+  start = now();
+  sink = (size_t) list_tree_locate(tree, path, path_length);
+  durations[OPERATION_LOCATE] = now() - start;
+
+  start = now();
+  list_tree_write(tree, long_writer, null_output, NULL, "{\n", "}\n");
+  fflush(null_output);
+  durations[OPERATION_WRITE] = now() - start;
+
+  start = now();
+  list_tree_dispose(tree, NULL);
+  durations[OPERATION_DISPOSE] = now() - start;
+
+  free(path);
+
+  tree = make_shape(shape, size);
+  list_tree_arena_t *arena = list_tree_arena_create(0);
+
+  start = now();
+  list_tree_arena_compact(arena, &tree);
+  durations[OPERATION_COMPACT] = now() - start;
+
+  /*
+    Like the search in the original tree, which comes after other
+    traversals, run this one with memory for the traversal stack
+    already taken from the system: growing it to the depth of the
+    deep shape costs more than the search itself.
+  */
+  sink = list_tree_size(tree);
+
+  start = now();
+  sink = (size_t) list_tree_find(tree, long_comparer, (void*) -1L);
+  durations[OPERATION_COMPACT_FIND_MISS] = now() - start;
+
+  list_tree_arena_release(arena, NULL);
+}
+
+static
+int
+compare_doubles(
+    void const* a,
+    void const* b)
+{
+  double x = *(double const*) a;
+  double y = *(double const*) b;
+
+  return (x > y) - (x < y);
+}
+
+static
+void
+report(
+    options_t const* options,
+    shape_t shape,
+    size_t size,
+    operation_t operation,
+    double *durations,
+    int *is_first)
+{
+  size_t count = options->repetitions;
+
+  qsort(durations, count, sizeof(double), compare_doubles);
+
+  double best = durations[0] / size;
+  double median = durations[count / 2] / size;
+  double rate = 0 == median ? 0 : 1e9 / median;
+
+  if (options->is_json)
+  {
+    printf(
+        "%s\n  {\"shape\": \"%s\", \"nodes\": %zu, \"operation\": \"%s\", "
+        "\"repetitions\": %zu, \"ns_per_node_best\": %.3f, "
+        "\"ns_per_node_median\": %.3f, \"nodes_per_sec\": %.0f}",
+        *is_first ? "" : ",",
+        shape_names[shape],
+        size,
+        operation_names[operation],
+        count,
+        best,
+        median,
+        rate);
+  }
+  else
+  {
+    printf(
+        "%s,%zu,%s,%zu,%.3f,%.3f,%.0f\n",
+        shape_names[shape],
+        size,
+        operation_names[operation],
+        count,
+        best,
+        median,
+        rate);
+  }
+
+  *is_first = 0;
+}
+
+static
+int
+parse_shapes(
+    char const* list,
+    int *shapes)
+{
+  memset(shapes, 0, SHAPE_COUNT * sizeof(int));
+
+  while ('\0' != *list)
+  {
+    size_t length = strcspn(list, ",");
+    int is_known = 0;
+
+    for (int i = 0; i < SHAPE_COUNT; ++i)
+    {
+      if (strlen(shape_names[i]) == length &&
+          0 == strncmp(list, shape_names[i], length))
+      {
+        shapes[i] = 1;
+        is_known = 1;
+      }
+    }
+
+    if (!is_known)
+      return 0;
+
+    list += length;
+    if (',' == *list)
+      ++ list;
+  }
+
+  return 1;
+}
+
+static
+int
+parse_options(
+    int argc,
+    char **argv,
+    options_t *options)
+{
+  options->min_size = 1000;
+  options->max_size = 1000000;
+  options->repetitions = 5;
+  options->warmup = 1;
+  options->is_json = 0;
+
+  for (int i = 0; i < SHAPE_COUNT; ++i)
+    options->shapes[i] = 1;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    char const* name = argv[i];
+    char const* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (NULL == value)
+      return 0;
+
+    if (0 == strcmp(name, "--min"))
+      options->min_size = strtoul(value, NULL, 10);
+    else if (0 == strcmp(name, "--max"))
+      options->max_size = strtoul(value, NULL, 10);
+    else if (0 == strcmp(name, "--repetitions"))
+      options->repetitions = strtoul(value, NULL, 10);
+    else if (0 == strcmp(name, "--warmup"))
+      options->warmup = strtoul(value, NULL, 10);
+    else if (0 == strcmp(name, "--format"))
+    {
+      if (0 == strcmp(value, "json"))
+        options->is_json = 1;
+      else if (0 == strcmp(value, "csv"))
+        options->is_json = 0;
+      else
+        return 0;
+    }
+    else if (0 == strcmp(name, "--shapes"))
+    {
+      if (!parse_shapes(value, options->shapes))
+        return 0;
+    }
+    else
+      return 0;
+
+    ++ i;
+  }
+
+  return
+    0 != options->min_size &&
+    options->min_size <= options->max_size &&
+    0 != options->repetitions;
+}
+
+int main(
+    int argc,
+    char **argv)
+{
+  options_t options;
+
+  if (!parse_options(argc, argv, &options))
+  {
+    fputs(
+        "Usage: list_tree_bench [--min N] [--max N] [--repetitions N]\n"
+        "                       [--warmup N] [--format csv|json]\n"
+        "                       [--shapes wide,deep,balanced,skewed,\n"
+        "                                 random,power_law,file_system]\n",
+        stderr);
+    return 1;
+  }
+
+  FILE *null_output = fopen("/dev/null", "w");
+
+  assert(NULL != null_output);
+
+  double *durations[OPERATION_COUNT];
+
+  for (int i = 0; i < OPERATION_COUNT; ++i)
+  {
+    durations[i] = (double*) malloc(options.repetitions * sizeof(double));
+    assert(NULL != durations[i]);
+  }
+
+  int is_first = 1;
+
+  if (options.is_json)
+    fputs("[", stdout);
+  else
+    puts("shape,nodes,operation,repetitions,ns_per_node_best,ns_per_node_median,nodes_per_sec");
+
+  for (int shape = 0; shape < SHAPE_COUNT; ++shape)
+  {
+    if (!options.shapes[shape])
+      continue;
+
+    for (size_t size = options.min_size; size <= options.max_size; size *= 10)
+    {
+      double round[OPERATION_COUNT];
+
+      for (size_t i = 0; i < options.warmup; ++i)
+        run_round((shape_t) shape, size, null_output, round);
+
+      for (size_t i = 0; i < options.repetitions; ++i)
+      {
+        run_round((shape_t) shape, size, null_output, round);
+
+        for (int operation = 0; operation < OPERATION_COUNT; ++operation)
+          durations[operation][i] = round[operation];
+      }
+
+      for (int operation = 0; operation < OPERATION_COUNT; ++operation)
+      {
+        report(
+            &options,
+            (shape_t) shape,
+            size,
+            (operation_t) operation,
+            durations[operation],
+            &is_first);
+      }
+
+      fflush(stdout);
+    }
+  }
+
+  if (options.is_json)
+    fputs("\n]\n", stdout);
+
+  for (int i = 0; i < OPERATION_COUNT; ++i)
+    free(durations[i]);
+
+  fclose(null_output);
+
+  return 0;
+}
@@ -0,0 +1,415 @@
+/*
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "list_tree.h"
+#include "list_tree_binary.h"
+#include "list_tree_frozen.h"
+
+static char const binary_magic[4] = { 'L', 'T', 'R', 'B' };
+static uint32_t const binary_byte_order = 0x01020304;
+static uint64_t const binary_none = UINT64_MAX;
+
+typedef struct _binary_header_t
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t reserved;
+  uint64_t node_count;
+  uint64_t depth;
+  uint64_t data_size;
+} binary_header_t;
+
+/*
+  Sections following the header, each aligned to 8 bytes:
+  - next, first child and subtree end: node_count indices each;
+  - data: data_size bytes, padded;
+  - offsets: node_count + 1 offsets of node data within the
+    data section, written last as they are known only then.
+*/
+struct _list_tree_mapped_t
+{
+  void *base;
+  size_t length;
+  binary_header_t const* header;
+  uint64_t const* next;
+  uint64_t const* first_child;
+  uint64_t const* subtree_end;
+  unsigned char const* data;
+  uint64_t const* offsets;
+};
+
+static
+uint64_t
+binary_padding(
+    uint64_t size)
+{
+  return (8 - size % 8) % 8;
+}
+
+static
+int
+binary_write_index(
+    uint64_t index,
+    FILE *output)
+{
+  return 1 == fwrite(&index, sizeof(index), 1, output);
+}
+
+static
+int
+binary_write_indices(
+    list_tree_frozen_t const* frozen,
+    size_t (*getter)(list_tree_frozen_t const*, size_t),
+    FILE *output)
+{
+  size_t count = list_tree_frozen_size(frozen);
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    size_t index = getter(frozen, i);
+
+    if (!binary_write_index(
+          LIST_TREE_FROZEN_NONE == index ? binary_none : index,
+          output))
+      return 0;
+  }
+
+  return 1;
+}
+
+int
+list_tree_frozen_save(
+    list_tree_frozen_t const* frozen,
+    data_encoder_t encoder,
+    FILE *output)
+{
+  assert(NULL != frozen);
+  assert(NULL != encoder);
+
+  size_t count = list_tree_frozen_size(frozen);
+  long header_position = ftell(output);
+
+  binary_header_t header;
+
+  memcpy(header.magic, binary_magic, sizeof(binary_magic));
+  header.version = LIST_TREE_BINARY_VERSION;
+  header.byte_order = binary_byte_order;
+  header.reserved = 0;
+  header.node_count = count;
+  header.depth = list_tree_frozen_depth(frozen);
+  header.data_size = 0;
+
+  if (1 != fwrite(&header, sizeof(header), 1, output) ||
+      !binary_write_indices(frozen, list_tree_frozen_get_next, output) ||
+      !binary_write_indices(frozen, list_tree_frozen_get_first_child, output) ||
+      !binary_write_indices(frozen, list_tree_frozen_get_subtree_end, output))
+    return 0;
+
+  uint64_t *offsets = (uint64_t*) malloc((count + 1) * sizeof(uint64_t));
+  size_t capacity = 256;
+  void *buffer = malloc(capacity);
+  int is_ok = 1;
+
+  assert(NULL != offsets);
+  assert(NULL != buffer);
+
+  offsets[0] = 0;
+
+  for (size_t i = 0; is_ok && i < count; ++i)
+  {
+    void const* data = list_tree_frozen_get_data(frozen, i);
+    size_t size = encoder(data, buffer, capacity);
+
+    if (size > capacity)
+    {
+      while (size > capacity)
+        capacity *= 2;
+
+      free(buffer);
+      buffer = malloc(capacity);
+
+      assert(NULL != buffer);
+
+      size = encoder(data, buffer, capacity);
+      assert(size <= capacity);
+    }
+
+    is_ok = 0 == size || 1 == fwrite(buffer, size, 1, output);
+    offsets[i + 1] = offsets[i] + size;
+  }
+
+  static unsigned char const zeros[8] = { 0 };
+  uint64_t padding = binary_padding(offsets[count]);
+
+  is_ok = is_ok &&
+    (0 == padding || 1 == fwrite(zeros, padding, 1, output)) &&
+    count + 1 == fwrite(offsets, sizeof(uint64_t), count + 1, output);
+
+  header.data_size = offsets[count];
+
+  free(buffer);
+  free(offsets);
+
+  if (!is_ok)
+    return 0;
+
+  long end_position = ftell(output);
+
+  return
+    0 == fseek(output, header_position, SEEK_SET) &&
+    1 == fwrite(&header, sizeof(header), 1, output) &&
+    0 == fseek(output, end_position, SEEK_SET) &&
+    0 == fflush(output);
+}
+
+int
+list_tree_save(
+    list_tree_node_t *root,
+    data_encoder_t encoder,
+    FILE *output)
+{
+  list_tree_frozen_t *frozen = list_tree_freeze(root);
+
+  int is_ok = list_tree_frozen_save(frozen, encoder, output);
+
+  list_tree_frozen_dispose(frozen, NULL);
+
+  return is_ok;
+}
+
+static
+int
+binary_check_header(
+    binary_header_t const* header,
+    size_t length)
+{
+  if (length < sizeof(binary_header_t) ||
+      0 != memcmp(header->magic, binary_magic, sizeof(binary_magic)) ||
+      LIST_TREE_BINARY_VERSION != header->version ||
+      binary_byte_order != header->byte_order)
+    return 0;
+
+  uint64_t count = header->node_count;
+  uint64_t available = (length - sizeof(binary_header_t)) / sizeof(uint64_t);
+
+  if (count > available / 4 ||
+      header->data_size / sizeof(uint64_t) > available)
+    return 0;
+
+  uint64_t data_words =
+    (header->data_size + binary_padding(header->data_size)) / sizeof(uint64_t);
+
+  return 4 * count + 1 + data_words <= available;
+}
+
+list_tree_mapped_t*
+list_tree_mapped_open(
+    char const* path)
+{
+  int fd = open(path, O_RDONLY);
+
+  if (0 > fd)
+    return NULL;
+
+  struct stat status;
+
+  if (0 != fstat(fd, &status) || 0 == status.st_size)
+  {
+    close(fd);
+    return NULL;
+  }
+
+  size_t length = (size_t) status.st_size;
+  void *base = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+
+  close(fd);
+
+  if (MAP_FAILED == base)
+    return NULL;
+
+  binary_header_t const* header = (binary_header_t const*) base;
+
+  if (!binary_check_header(header, length))
+  {
+    munmap(base, length);
+    return NULL;
+  }
+
+  list_tree_mapped_t *mapped =
+    (list_tree_mapped_t*) malloc(sizeof(list_tree_mapped_t));
+
+  assert(NULL != mapped);
+
+  uint64_t count = header->node_count;
+  uint64_t const* indices = (uint64_t const*) (header + 1);
+
+  mapped->base = base;
+  mapped->length = length;
+  mapped->header = header;
+  mapped->next = indices;
+  mapped->first_child = indices + count;
+  mapped->subtree_end = indices + 2 * count;
+  mapped->data = (unsigned char const*) (indices + 3 * count);
+  mapped->offsets = (uint64_t const*) (mapped->data +
+      header->data_size + binary_padding(header->data_size));
+
+  return mapped;
+}
+
+void
+list_tree_mapped_close(
+    list_tree_mapped_t *mapped)
+{
+  assert(NULL != mapped);
+
+  munmap(mapped->base, mapped->length);
+  free(mapped);
+}
+
+static
+size_t
+binary_index(
+    uint64_t index)
+{
+  return binary_none == index ? LIST_TREE_FROZEN_NONE : (size_t) index;
+}
+
+void const*
+list_tree_mapped_get_data(
+    list_tree_mapped_t const* mapped,
+    size_t index,
+    size_t *data_size)
+{
+  assert(index < mapped->header->node_count);
+
+  if (NULL != data_size)
+    *data_size = mapped->offsets[index + 1] - mapped->offsets[index];
+
+  return mapped->data + mapped->offsets[index];
+}
+
+size_t
+list_tree_mapped_get_next(
+    list_tree_mapped_t const* mapped,
+    size_t index)
+{
+  assert(index < mapped->header->node_count);
+
+  return binary_index(mapped->next[index]);
+}
+
+size_t
+list_tree_mapped_get_first_child(
+    list_tree_mapped_t const* mapped,
+    size_t index)
+{
+  assert(index < mapped->header->node_count);
+
+  return binary_index(mapped->first_child[index]);
+}
+
+size_t
+list_tree_mapped_get_subtree_end(
+    list_tree_mapped_t const* mapped,
+    size_t index)
+{
+  assert(index < mapped->header->node_count);
+
+  return binary_index(mapped->subtree_end[index]);
+}
+
+size_t
+list_tree_mapped_size(
+    list_tree_mapped_t const* mapped)
+{
+  assert(NULL != mapped);
+
+  return (size_t) mapped->header->node_count;
+}
+
+size_t
+list_tree_mapped_length(
+    list_tree_mapped_t const* mapped)
+{
+  assert(NULL != mapped);
+
+  if (0 == mapped->header->node_count)
+    return 0;
+
+  size_t length = 0;
+
+  for (uint64_t i = 0; binary_none != i; i = mapped->next[i])
+    ++ length;
+
+  return length;
+}
+
+size_t
+list_tree_mapped_depth(
+    list_tree_mapped_t const* mapped)
+{
+  assert(NULL != mapped);
+
+  return (size_t) mapped->header->depth;
+}
+
+size_t
+list_tree_mapped_find(
+    list_tree_mapped_t const* mapped,
+    predicate_t predicate,
+    void *predicate_param)
+{
+  assert(NULL != mapped);
+  assert(NULL != predicate);
+
+  size_t count = (size_t) mapped->header->node_count;
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (predicate(mapped->data + mapped->offsets[i], predicate_param))
+      return i;
+  }
+
+  return LIST_TREE_FROZEN_NONE;
+}
+
+size_t
+list_tree_mapped_locate(
+    list_tree_mapped_t const* mapped,
+    size_t const* path,
+    size_t path_length)
+{
+  assert(NULL != mapped);
+
+  if (0 == path_length || 0 == mapped->header->node_count)
+    return LIST_TREE_FROZEN_NONE;
+
+  uint64_t index = 0;
+
+  for (size_t level = 0; level < path_length; ++level)
+  {
+    if (0 != level)
+      index = mapped->first_child[index];
+
+    for (size_t i = 0; i < path[level] && binary_none != index; ++i)
+      index = mapped->next[index];
+
+    if (binary_none == index)
+      break;
+  }
+
+  return binary_index(index);
+}
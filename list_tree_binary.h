@@ -0,0 +1,118 @@
+/*
+   Binary files of list-trees.
+
+   A tree is saved in the frozen layout (see list_tree_frozen.h):
+   a versioned header followed by arrays of next, first child and
+   subtree end indices, the encoded data of all nodes and a table
+   of offsets of each node's data.  All numbers are 64-bit in the
+   byte order of the machine that wrote the file; a file written
+   with another byte order is rejected.
+
+   Loading maps the file into memory and uses it in place, so the
+   cost of opening a file does not depend on the size of the tree.
+   The header and the sizes of the sections are checked on open;
+   indices stored in the file are trusted.
+
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#ifndef _LIST_TREE_BINARY_H_
+#define _LIST_TREE_BINARY_H_
+
+#include <stdio.h>
+#include "list_tree.h"
+#include "list_tree_frozen.h"
+
+#define LIST_TREE_BINARY_VERSION 1
+
+/*
+  Callback to encode node data into a buffer of the given
+  capacity.  Returns the size of the encoding; if it exceeds the
+  capacity, the callback is called again with a larger buffer.
+*/
+typedef
+  size_t
+  (*data_encoder_t)(
+      void const* data,
+      void *buffer,
+      size_t capacity);
+
+typedef
+  struct _list_tree_mapped_t
+  list_tree_mapped_t;
+
+/* Save a tree to a file; return false (0) on an output error */
+int
+list_tree_save(
+    list_tree_node_t *root,
+    data_encoder_t encoder,
+    FILE *output);
+
+int
+list_tree_frozen_save(
+    list_tree_frozen_t const* frozen,
+    data_encoder_t encoder,
+    FILE *output);
+
+/* Map a saved tree into memory; return NULL on failure */
+list_tree_mapped_t*
+list_tree_mapped_open(
+    char const* path);
+
+void
+list_tree_mapped_close(
+    list_tree_mapped_t *mapped);
+
+/*
+  Getters.  Indices are those of the frozen layout; data points
+  into the mapped file and is valid until the file is closed.
+*/
+void const*
+list_tree_mapped_get_data(
+    list_tree_mapped_t const* mapped,
+    size_t index,
+    size_t *data_size);
+
+size_t
+list_tree_mapped_get_next(
+    list_tree_mapped_t const* mapped,
+    size_t index);
+
+size_t
+list_tree_mapped_get_first_child(
+    list_tree_mapped_t const* mapped,
+    size_t index);
+
+size_t
+list_tree_mapped_get_subtree_end(
+    list_tree_mapped_t const* mapped,
+    size_t index);
+
+/* Various functions, same as for frozen list-trees */
+size_t
+list_tree_mapped_size(
+    list_tree_mapped_t const* mapped);
+
+size_t
+list_tree_mapped_length(
+    list_tree_mapped_t const* mapped);
+
+size_t
+list_tree_mapped_depth(
+    list_tree_mapped_t const* mapped);
+
+/* The predicate is given a pointer to the encoded data */
+size_t
+list_tree_mapped_find(
+    list_tree_mapped_t const* mapped,
+    predicate_t predicate,
+    void *predicate_param);
+
+size_t
+list_tree_mapped_locate(
+    list_tree_mapped_t const* mapped,
+    size_t const* path,
+    size_t path_length);
+
+#endif
@@ -0,0 +1,145 @@
+/*
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include "list_tree.h"
+#include "list_tree_builder.h"
+#include "list_tree_map.h"
+#include "list_tree_node.h"
+
+/*
+  Tails are kept by parent, the tail of the root list separately
+  as it has no parent.
+*/
+struct _list_tree_builder_t
+{
+  list_tree_node_t *root;
+  list_tree_node_t *root_tail;
+  list_tree_map_t tails;
+};
+
+list_tree_builder_t*
+list_tree_builder_create(
+    list_tree_node_t *root)
+{
+  list_tree_builder_t *builder =
+    (list_tree_builder_t*) malloc(sizeof(list_tree_builder_t));
+
+  assert(NULL != builder);
+
+  builder->root = root;
+  builder->root_tail = NULL;
+  list_tree_map_init(&builder->tails);
+
+  return builder;
+}
+
+void
+list_tree_builder_dispose(
+    list_tree_builder_t *builder)
+{
+  assert(NULL != builder);
+
+  list_tree_map_dispose(&builder->tails);
+  free(builder);
+}
+
+list_tree_node_t*
+list_tree_builder_root(
+    list_tree_builder_t const* builder)
+{
+  assert(NULL != builder);
+
+  return builder->root;
+}
+
+static
+list_tree_node_t*
+last_of(
+    list_tree_node_t *node)
+{
+  while (NULL != node->next)
+    node = node->next;
+
+  return node;
+}
+
+/*
+  The tail of a list the builder has not appended to yet is found
+  by a walk, once.
+*/
+static
+list_tree_node_t*
+builder_tail(
+    list_tree_builder_t *builder,
+    list_tree_node_t *parent)
+{
+  if (NULL == parent)
+  {
+    if (NULL == builder->root_tail && NULL != builder->root)
+      builder->root_tail = last_of(builder->root);
+
+    return builder->root_tail;
+  }
+
+  list_tree_node_t *tail =
+    (list_tree_node_t*) list_tree_map_get(&builder->tails, parent);
+
+  if (NULL == tail)
+  {
+    if (NULL != parent->first_child)
+      tail = last_of(parent->first_child);
+  }
+
+  return tail;
+}
+
+void
+list_tree_builder_append_chain(
+    list_tree_builder_t *builder,
+    list_tree_node_t *parent,
+    list_tree_node_t *first,
+    list_tree_node_t *last)
+{
+  assert(NULL != builder);
+  assert(NULL != first);
+
+  assert(0 == (first->flags & NODE_AUGMENTED));
+
+  if (NULL == last)
+    last = last_of(first);
+
+  assert(NULL == last->next);
+
+  list_tree_node_t *tail = builder_tail(builder, parent);
+
+  if (NULL != tail)
+    tail->next = first;
+  else if (NULL != parent)
+    parent->first_child = first;
+  else
+    builder->root = first;
+
+  if (NULL == parent)
+    builder->root_tail = last;
+  else
+    list_tree_map_put(&builder->tails, parent, last);
+}
+
+list_tree_node_t*
+list_tree_builder_append_child(
+    list_tree_builder_t *builder,
+    list_tree_node_t *parent,
+    list_tree_node_t *node)
+{
+  list_tree_builder_append_chain(
+      builder,
+      parent,
+      node,
+      node);
+
+  return node;
+}
@@ -0,0 +1,64 @@
+/*
+   Building list-trees in natural order.
+
+   Appending to a list with list_tree_append takes its last node,
+   which is found by walking the list.  A builder remembers the
+   last node of every list it has appended to, so that appending
+   to the end of any list costs O(1), and building a tree node by
+   node in depth-first or breadth-first order takes linear time.
+
+   The lists a builder appends to must not be changed otherwise
+   while it is in use.  Nodes appended must not be augmented.
+
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#ifndef _LIST_TREE_BUILDER_H_
+#define _LIST_TREE_BUILDER_H_
+
+#include "list_tree.h"
+
+typedef
+  struct _list_tree_builder_t
+  list_tree_builder_t;
+
+/* Create a builder of the tree at the root, which may be NULL */
+list_tree_builder_t*
+list_tree_builder_create(
+    list_tree_node_t *root);
+
+/* Free the builder, but not the tree */
+void
+list_tree_builder_dispose(
+    list_tree_builder_t *builder);
+
+/* First node of the root list */
+list_tree_node_t*
+list_tree_builder_root(
+    list_tree_builder_t const* builder);
+
+/*
+  Append the node, which must have no next node, to the end of the
+  children of the parent, or of the root list if the parent is
+  NULL.  Returns the node.
+*/
+list_tree_node_t*
+list_tree_builder_append_child(
+    list_tree_builder_t *builder,
+    list_tree_node_t *parent,
+    list_tree_node_t *node);
+
+/*
+  Append a list of nodes linked with each other from first to
+  last in the same way.  If last is NULL, it is found by walking
+  the list.
+*/
+void
+list_tree_builder_append_chain(
+    list_tree_builder_t *builder,
+    list_tree_node_t *parent,
+    list_tree_node_t *first,
+    list_tree_node_t *last);
+
+#endif
@@ -0,0 +1,226 @@
+/*
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include "list_tree.h"
+#include "list_tree_cursor.h"
+#include "list_tree_node.h"
+
+enum { CURSOR_INITIAL_CAPACITY = 16 };
+
+void
+list_tree_cursor_init(
+    list_tree_cursor_t *cursor,
+    list_tree_node_t *root)
+{
+  assert(NULL != cursor);
+
+  cursor->root = root;
+  cursor->node = NULL;
+  cursor->ancestors = NULL;
+  cursor->depth = 0;
+  cursor->capacity = 0;
+  cursor->started = 0;
+}
+
+void
+list_tree_cursor_dispose(
+    list_tree_cursor_t *cursor)
+{
+  assert(NULL != cursor);
+
+  free(cursor->ancestors);
+  cursor->ancestors = NULL;
+  cursor->capacity = 0;
+}
+
+list_tree_node_t*
+list_tree_cursor_node(
+    list_tree_cursor_t const* cursor)
+{
+  assert(NULL != cursor);
+
+  return cursor->node;
+}
+
+size_t
+list_tree_cursor_depth(
+    list_tree_cursor_t const* cursor)
+{
+  assert(NULL != cursor);
+
+  return cursor->depth;
+}
+
+static
+void
+cursor_push(
+    list_tree_cursor_t *cursor)
+{
+  if (cursor->depth == cursor->capacity)
+  {
+    cursor->capacity = 0 == cursor->capacity
+      ? CURSOR_INITIAL_CAPACITY
+      : 2 * cursor->capacity;
+    cursor->ancestors = (list_tree_node_t**) realloc(
+        cursor->ancestors,
+        cursor->capacity * sizeof(list_tree_node_t*));
+
+    assert(NULL != cursor->ancestors);
+  }
+
+  cursor->ancestors[cursor->depth ++] = cursor->node;
+}
+
+/* Go down along first children as far as possible */
+static
+void
+cursor_descend_leftmost(
+    list_tree_cursor_t *cursor)
+{
+  list_tree_node_t *first_child;
+
+  while (NULL != (first_child = list_tree_node_first_child(cursor->node)))
+  {
+    cursor_push(cursor);
+    cursor->node = first_child;
+  }
+}
+
+/*
+  Start the walk at the root, or tell whether it is over.  Returns
+  0 if there is nothing to move from.
+*/
+static
+int
+cursor_start(
+    list_tree_cursor_t *cursor)
+{
+  if (cursor->started)
+    return NULL != cursor->node;
+
+  cursor->started = 1;
+  cursor->node = cursor->root;
+
+  return 0;
+}
+
+int
+list_tree_cursor_next_preorder(
+    list_tree_cursor_t *cursor)
+{
+  assert(NULL != cursor);
+
+  if (!cursor_start(cursor))
+    return NULL != cursor->node;
+
+  list_tree_node_t *node = cursor->node;
+  list_tree_node_t *first_child = list_tree_node_first_child(node);
+
+  if (NULL != first_child)
+  {
+    cursor_push(cursor);
+    cursor->node = first_child;
+    return 1;
+  }
+
+  list_tree_node_t *next;
+
+  while (NULL == (next = list_tree_node_next(node)))
+  {
+    if (0 == cursor->depth)
+    {
+      cursor->node = NULL;
+      return 0;
+    }
+
+    node = cursor->ancestors[-- cursor->depth];
+  }
+
+  cursor->node = next;
+  return 1;
+}
+
+int
+list_tree_cursor_next_postorder(
+    list_tree_cursor_t *cursor)
+{
+  assert(NULL != cursor);
+
+  if (!cursor_start(cursor))
+  {
+    if (NULL == cursor->node)
+      return 0;
+
+    cursor_descend_leftmost(cursor);
+    return 1;
+  }
+
+  list_tree_node_t *next = list_tree_node_next(cursor->node);
+
+  if (NULL != next)
+  {
+    cursor->node = next;
+    cursor_descend_leftmost(cursor);
+    return 1;
+  }
+
+  if (0 == cursor->depth)
+  {
+    cursor->node = NULL;
+    return 0;
+  }
+
+  cursor->node = cursor->ancestors[-- cursor->depth];
+  return 1;
+}
+
+int
+list_tree_cursor_descend(
+    list_tree_cursor_t *cursor)
+{
+  assert(NULL != cursor);
+  assert(NULL != cursor->node);
+
+  list_tree_node_t *first_child = list_tree_node_first_child(cursor->node);
+
+  if (NULL == first_child)
+    return 0;
+
+  cursor_push(cursor);
+  cursor->node = first_child;
+  return 1;
+}
+
+int
+list_tree_cursor_advance(
+    list_tree_cursor_t *cursor)
+{
+  assert(NULL != cursor);
+  assert(NULL != cursor->node);
+
+  list_tree_node_t *next = list_tree_node_next(cursor->node);
+
+  if (NULL == next)
+    return 0;
+
+  cursor->node = next;
+  return 1;
+}
+
+int
+list_tree_cursor_up(
+    list_tree_cursor_t *cursor)
+{
+  assert(NULL != cursor);
+  assert(NULL != cursor->node);
+
+  if (0 == cursor->depth)
+    return 0;
+
+  cursor->node = cursor->ancestors[-- cursor->depth];
+  return 1;
+}
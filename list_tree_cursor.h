@@ -0,0 +1,90 @@
+/*
+   Pull-based iteration over list-trees.
+
+   A cursor stands on a node and keeps the chain of its ancestors
+   in an explicit stack, so the caller drives the walk with plain
+   loops instead of callbacks:
+
+     list_tree_cursor_t cursor;
+     list_tree_cursor_init(&cursor, root);
+     while (list_tree_cursor_next_preorder(&cursor))
+       visit(list_tree_cursor_node(&cursor));
+     list_tree_cursor_dispose(&cursor);
+
+   A freshly initialised cursor stands before the first node;
+   the first call to either next function moves it to the first
+   node of the corresponding order.  Once the walk is over, the
+   cursor stands on no node and the next functions return 0.
+
+   Pre-order visits a node before its descendants, post-order
+   after them; in both orders a node comes after its previous
+   siblings and their descendants.  The two orders and the single
+   steps may be mixed freely.  The tree must not be changed along
+   the current path while the cursor is in use.
+
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#ifndef _LIST_TREE_CURSOR_H_
+#define _LIST_TREE_CURSOR_H_
+
+#include "list_tree.h"
+
+typedef struct _list_tree_cursor_t
+{
+  list_tree_node_t *root;
+  list_tree_node_t *node;
+  list_tree_node_t **ancestors;
+  size_t depth;
+  size_t capacity;
+  int started;
+} list_tree_cursor_t;
+
+void
+list_tree_cursor_init(
+    list_tree_cursor_t *cursor,
+    list_tree_node_t *root);
+
+void
+list_tree_cursor_dispose(
+    list_tree_cursor_t *cursor);
+
+/* Return the current node, or NULL before and after the walk */
+list_tree_node_t*
+list_tree_cursor_node(
+    list_tree_cursor_t const* cursor);
+
+/* Number of ancestors of the current node; 0 in the root list */
+size_t
+list_tree_cursor_depth(
+    list_tree_cursor_t const* cursor);
+
+/* Move to the next node in pre-order; return 0 at the end */
+int
+list_tree_cursor_next_preorder(
+    list_tree_cursor_t *cursor);
+
+/* Move to the next node in post-order; return 0 at the end */
+int
+list_tree_cursor_next_postorder(
+    list_tree_cursor_t *cursor);
+
+/*
+  Single steps from the current node: to its first child, to its
+  next sibling, or to its parent.  If there is no such node, the
+  cursor stays where it is and 0 is returned.
+*/
+int
+list_tree_cursor_descend(
+    list_tree_cursor_t *cursor);
+
+int
+list_tree_cursor_advance(
+    list_tree_cursor_t *cursor);
+
+int
+list_tree_cursor_up(
+    list_tree_cursor_t *cursor);
+
+#endif
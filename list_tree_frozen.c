@@ -0,0 +1,418 @@
+/*
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include "list_tree.h"
+#include "list_tree_frozen.h"
+
+struct _list_tree_frozen_t
+{
+  size_t count;
+  size_t capacity;
+  size_t depth;
+  void **data;
+  size_t *next;
+  size_t *first_child;
+  size_t *subtree_end;
+};
+
+typedef struct _freeze_state_t
+{
+  list_tree_frozen_t *frozen;
+  size_t *last;
+  size_t level;
+  size_t level_capacity;
+} freeze_state_t;
+
+static
+void
+freeze_reserve(
+    list_tree_frozen_t *frozen,
+    size_t capacity)
+{
+  frozen->data = (void**) realloc(
+      frozen->data,
+      capacity * sizeof(void*));
+  frozen->next = (size_t*) realloc(
+      frozen->next,
+      capacity * sizeof(size_t));
+  frozen->first_child = (size_t*) realloc(
+      frozen->first_child,
+      capacity * sizeof(size_t));
+  frozen->subtree_end = (size_t*) realloc(
+      frozen->subtree_end,
+      capacity * sizeof(size_t));
+
+  assert(NULL != frozen->data);
+  assert(NULL != frozen->next);
+  assert(NULL != frozen->first_child);
+  assert(NULL != frozen->subtree_end);
+
+  frozen->capacity = capacity;
+}
+
+static
+int
+freeze_pre_visitor(
+    list_tree_node_t *node,
+    void *raw_state)
+{
+  assert(NULL != raw_state);
+
+  freeze_state_t *state = (freeze_state_t*) raw_state;
+  list_tree_frozen_t *frozen = state->frozen;
+
+  if (frozen->count == frozen->capacity)
+    freeze_reserve(frozen, 2 * frozen->capacity);
+
+  size_t index = frozen->count ++;
+
+  frozen->data[index] = list_tree_get_data(node);
+  frozen->next[index] = LIST_TREE_FROZEN_NONE;
+  frozen->first_child[index] = LIST_TREE_FROZEN_NONE;
+  frozen->subtree_end[index] = index + 1;
+
+  size_t *last = &state->last[state->level];
+
+  if (LIST_TREE_FROZEN_NONE != *last)
+    frozen->next[*last] = index;
+  else if (0 != state->level)
+    frozen->first_child[state->last[state->level - 1]] = index;
+
+  *last = index;
+
+  return 1;
+}
+
+static
+int
+freeze_descent(
+    void *raw_state)
+{
+  assert(NULL != raw_state);
+
+  freeze_state_t *state = (freeze_state_t*) raw_state;
+
+  ++ state->level;
+
+  if (state->level == state->level_capacity)
+  {
+    state->level_capacity *= 2;
+    state->last = (size_t*) realloc(
+        state->last,
+        state->level_capacity * sizeof(size_t));
+    assert(NULL != state->last);
+  }
+
+  state->last[state->level] = LIST_TREE_FROZEN_NONE;
+
+  if (state->frozen->depth < state->level)
+    state->frozen->depth = state->level;
+
+  return 1;
+}
+
+static
+void
+freeze_ascent(
+    void *raw_state)
+{
+  assert(NULL != raw_state);
+
+  freeze_state_t *state = (freeze_state_t*) raw_state;
+
+  assert(0 < state->level);
+
+  -- state->level;
+
+  list_tree_frozen_t *frozen = state->frozen;
+  frozen->subtree_end[state->last[state->level]] = frozen->count;
+}
+
+list_tree_frozen_t*
+list_tree_freeze(
+    list_tree_node_t *root)
+{
+  list_tree_frozen_t *frozen =
+    (list_tree_frozen_t*) calloc(1, sizeof(list_tree_frozen_t));
+
+  assert(NULL != frozen);
+
+  freeze_reserve(frozen, 64);
+
+  freeze_state_t state =
+  {
+    frozen,
+    (size_t*) malloc(16 * sizeof(size_t)),
+    0,
+    16
+  };
+
+  assert(NULL != state.last);
+  state.last[0] = LIST_TREE_FROZEN_NONE;
+
+  list_tree_traverse_depth(
+      root,
+      freeze_pre_visitor,
+      freeze_descent,
+      freeze_ascent,
+      NULL,
+      NULL,
+      NULL,
+      &state);
+
+  free(state.last);
+
+  if (0 != frozen->count)
+  {
+    ++ frozen->depth;
+    freeze_reserve(frozen, frozen->count);
+  }
+
+  return frozen;
+}
+
+/*
+  Links of a node always point forward, so building the nodes
+  from the last one to the first finds both the next node and the
+  first child already made.
+*/
+list_tree_node_t*
+list_tree_thaw(
+    list_tree_frozen_t const* frozen)
+{
+  assert(NULL != frozen);
+
+  if (0 == frozen->count)
+    return NULL;
+
+  list_tree_node_t **nodes = (list_tree_node_t**) malloc(
+      frozen->count * sizeof(list_tree_node_t*));
+
+  assert(NULL != nodes);
+
+  for (size_t i = frozen->count; i != 0; --i)
+  {
+    size_t index = i - 1;
+    size_t next = frozen->next[index];
+    size_t first_child = frozen->first_child[index];
+
+    nodes[index] = list_tree_make(
+        frozen->data[index],
+        LIST_TREE_FROZEN_NONE == next ? NULL : nodes[next],
+        LIST_TREE_FROZEN_NONE == first_child ? NULL : nodes[first_child]);
+  }
+
+  list_tree_node_t *root = nodes[0];
+
+  free(nodes);
+
+  return root;
+}
+
+void
+list_tree_frozen_dispose(
+    list_tree_frozen_t *frozen,
+    data_disposer_t data_disposer)
+{
+  assert(NULL != frozen);
+
+  if (NULL != data_disposer)
+  {
+    for (size_t i = 0; i < frozen->count; ++i)
+      data_disposer(frozen->data[i]);
+  }
+
+  free(frozen->data);
+  free(frozen->next);
+  free(frozen->first_child);
+  free(frozen->subtree_end);
+  free(frozen);
+}
+
+void*
+list_tree_frozen_get_data(
+    list_tree_frozen_t const* frozen,
+    size_t index)
+{
+  assert(index < frozen->count);
+
+  return frozen->data[index];
+}
+
+size_t
+list_tree_frozen_get_next(
+    list_tree_frozen_t const* frozen,
+    size_t index)
+{
+  assert(index < frozen->count);
+
+  return frozen->next[index];
+}
+
+size_t
+list_tree_frozen_get_first_child(
+    list_tree_frozen_t const* frozen,
+    size_t index)
+{
+  assert(index < frozen->count);
+
+  return frozen->first_child[index];
+}
+
+size_t
+list_tree_frozen_get_subtree_end(
+    list_tree_frozen_t const* frozen,
+    size_t index)
+{
+  assert(index < frozen->count);
+
+  return frozen->subtree_end[index];
+}
+
+size_t
+list_tree_frozen_size(
+    list_tree_frozen_t const* frozen)
+{
+  assert(NULL != frozen);
+
+  return frozen->count;
+}
+
+size_t
+list_tree_frozen_length(
+    list_tree_frozen_t const* frozen)
+{
+  assert(NULL != frozen);
+
+  if (0 == frozen->count)
+    return 0;
+
+  size_t length = 0;
+
+  for (size_t i = 0; LIST_TREE_FROZEN_NONE != i; i = frozen->next[i])
+    ++ length;
+
+  return length;
+}
+
+size_t
+list_tree_frozen_depth(
+    list_tree_frozen_t const* frozen)
+{
+  assert(NULL != frozen);
+
+  return frozen->depth;
+}
+
+size_t
+list_tree_frozen_find(
+    list_tree_frozen_t const* frozen,
+    predicate_t predicate,
+    void *predicate_param)
+{
+  assert(NULL != frozen);
+  assert(NULL != predicate);
+
+  void * const* data = frozen->data;
+  size_t count = frozen->count;
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (predicate(data[i], predicate_param))
+      return i;
+  }
+
+  return LIST_TREE_FROZEN_NONE;
+}
+
+size_t
+list_tree_frozen_locate(
+    list_tree_frozen_t const* frozen,
+    size_t const* path,
+    size_t path_length)
+{
+  assert(NULL != frozen);
+
+  if (0 == path_length || 0 == frozen->count)
+    return LIST_TREE_FROZEN_NONE;
+
+  size_t index = 0;
+
+  for (size_t level = 0; level < path_length; ++level)
+  {
+    if (0 != level && LIST_TREE_FROZEN_NONE != index)
+      index = frozen->first_child[index];
+
+    for (size_t i = 0; i < path[level] && LIST_TREE_FROZEN_NONE != index; ++i)
+      index = frozen->next[index];
+
+    if (LIST_TREE_FROZEN_NONE == index)
+      break;
+  }
+
+  return index;
+}
+
+/*
+  Nodes are written in the order they are stored.  A stack of the
+  subtree ends of the currently open nodes tells where to close
+  them; its height never exceeds the depth of the tree.
+*/
+void
+list_tree_frozen_write(
+    list_tree_frozen_t const* frozen,
+    data_writer_t writer,
+    FILE *output,
+    char const* indent,
+    char const* opening_tag,
+    char const* closing_tag)
+{
+  assert(NULL != frozen);
+
+  if (0 == frozen->count)
+    return;
+
+  size_t *ends = (size_t*) malloc(frozen->depth * sizeof(size_t));
+  size_t level = 0;
+
+  assert(NULL != ends);
+
+  for (size_t i = 0; i < frozen->count; ++i)
+  {
+    while (0 != level && ends[level - 1] == i)
+    {
+      if (NULL != closing_tag)
+        fputs(closing_tag, output);
+
+      -- level;
+    }
+
+    if (NULL != indent)
+    {
+      for (size_t j = 0; j < level; ++j)
+        fputs(indent, output);
+    }
+
+    writer(output, frozen->data[i]);
+
+    if (LIST_TREE_FROZEN_NONE != frozen->first_child[i])
+    {
+      if (NULL != opening_tag)
+        fputs(opening_tag, output);
+
+      ends[level ++] = frozen->subtree_end[i];
+    }
+  }
+
+  for (; 0 != level; --level)
+  {
+    if (NULL != closing_tag)
+      fputs(closing_tag, output);
+  }
+
+  free(ends);
+}
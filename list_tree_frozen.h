@@ -0,0 +1,107 @@
+/*
+   Frozen list-trees.
+
+   A frozen list-tree is an immutable copy of a linked one stored
+   as parallel arrays indexed by the position of a node in the
+   depth-first (pre-order) sequence: the root has index 0, a first
+   child immediately follows its parent, and the descendants of a
+   node occupy the range of indices from the node itself up to,
+   but excluding, its subtree end.  Read-only operations on this
+   form are linear scans over contiguous memory rather than walks
+   over scattered nodes.
+
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#ifndef _LIST_TREE_FROZEN_H_
+#define _LIST_TREE_FROZEN_H_
+
+#include <stdio.h>
+#include "list_tree.h"
+
+typedef
+  struct _list_tree_frozen_t
+  list_tree_frozen_t;
+
+/* Index standing for a missing next node or first child */
+#define LIST_TREE_FROZEN_NONE ((size_t) -1)
+
+/* Conversion */
+list_tree_frozen_t*
+list_tree_freeze(
+    list_tree_node_t *root);
+
+list_tree_node_t*
+list_tree_thaw(
+    list_tree_frozen_t const* frozen);
+
+/*
+  Free the frozen tree; data_disposer, if not NULL, is called on
+  the data of each node.  The linked tree the frozen one was made
+  from shares the data and is not affected otherwise.
+*/
+void
+list_tree_frozen_dispose(
+    list_tree_frozen_t *frozen,
+    data_disposer_t data_disposer);
+
+/* Getters */
+void*
+list_tree_frozen_get_data(
+    list_tree_frozen_t const* frozen,
+    size_t index);
+
+size_t
+list_tree_frozen_get_next(
+    list_tree_frozen_t const* frozen,
+    size_t index);
+
+size_t
+list_tree_frozen_get_first_child(
+    list_tree_frozen_t const* frozen,
+    size_t index);
+
+size_t
+list_tree_frozen_get_subtree_end(
+    list_tree_frozen_t const* frozen,
+    size_t index);
+
+/* Various functions, same as for linked list-trees */
+size_t
+list_tree_frozen_size(
+    list_tree_frozen_t const* frozen);
+
+size_t
+list_tree_frozen_length(
+    list_tree_frozen_t const* frozen);
+
+size_t
+list_tree_frozen_depth(
+    list_tree_frozen_t const* frozen);
+
+/* Return the index of the first matching node, or NONE */
+size_t
+list_tree_frozen_find(
+    list_tree_frozen_t const* frozen,
+    predicate_t predicate,
+    void *predicate_param);
+
+/* Return the index of the node at the path, or NONE */
+size_t
+list_tree_frozen_locate(
+    list_tree_frozen_t const* frozen,
+    size_t const* path,
+    size_t path_length);
+
+/* Output */
+void
+list_tree_frozen_write(
+    list_tree_frozen_t const* frozen,
+    data_writer_t writer,
+    FILE *output,
+    char const* indent,
+    char const* opening_tag,
+    char const* closing_tag);
+
+#endif
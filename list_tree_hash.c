@@ -0,0 +1,515 @@
+/*
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "list_tree.h"
+#include "list_tree_hash.h"
+#include "list_tree_map.h"
+#include "list_tree_node.h"
+
+enum
+{
+  HASH_NODE_SEED = 0x2545F491,
+  HASH_LIST_SEED = 0x4F6CDD1D
+};
+
+/*
+  Hashes of the nodes of a single call: cached in the metadata of
+  augmented nodes and kept in the map for the others.
+*/
+typedef struct _hash_context_t
+{
+  data_hasher_t hasher;
+  list_tree_map_t map;
+} hash_context_t;
+
+/*
+  A list being hashed: its first node, the node being hashed with
+  the hash of its data, and the hash of the nodes before it.
+*/
+typedef struct _hash_level_t
+{
+  list_tree_node_t *first;
+  list_tree_node_t *node;
+  size_t data_hash;
+  size_t hash;
+} hash_level_t;
+
+/* A pair of nodes matched by their path, with the last index of the path */
+typedef struct _pair_frame_t
+{
+  list_tree_node_t *a;
+  list_tree_node_t *b;
+  size_t depth;
+  size_t index;
+} pair_frame_t;
+
+static
+size_t
+hash_mix(
+    size_t seed,
+    size_t value)
+{
+  return seed ^
+    (value + (size_t) 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2));
+}
+
+/* Zero is left for the empty list, and for an unknown hash */
+static
+size_t
+hash_nonzero(
+    size_t hash)
+{
+  return 0 == hash ? 1 : hash;
+}
+
+/* Hash of the node with its children if known, 0 otherwise */
+static
+size_t
+node_hash_known(
+    hash_context_t const* context,
+    list_tree_node_t *node)
+{
+  if (0 != (node->flags & NODE_AUGMENTED))
+  {
+    list_tree_augment_t const* augment = list_tree_augment_of(node);
+
+    return augment->hasher == context->hasher ? augment->hash : 0;
+  }
+
+  return (size_t) (uintptr_t) list_tree_map_get(&context->map, node);
+}
+
+static
+void
+node_hash_store(
+    hash_context_t *context,
+    list_tree_node_t *node,
+    size_t hash)
+{
+  if (0 != (node->flags & NODE_AUGMENTED))
+  {
+    list_tree_augment_t *augment = list_tree_augment_of(node);
+
+    augment->hash = hash;
+    augment->hasher = context->hasher;
+  }
+  else
+  {
+    list_tree_map_put(&context->map, node, (void*) (uintptr_t) hash);
+  }
+}
+
+/*
+  Hash of the list starting from first if known, 0 otherwise.  It
+  is only cached for whole augmented lists.
+*/
+static
+size_t
+list_hash_known(
+    hash_context_t const* context,
+    list_tree_node_t *first)
+{
+  if (0 == (first->flags & NODE_AUGMENTED))
+    return 0;
+
+  list_tree_augment_list_t const* list = list_tree_augment_of(first)->list;
+
+  return list->first == first && list->hasher == context->hasher
+    ? list->hash
+    : 0;
+}
+
+static
+void
+list_hash_store(
+    hash_context_t *context,
+    list_tree_node_t *first,
+    size_t hash)
+{
+  if (0 == (first->flags & NODE_AUGMENTED))
+    return;
+
+  list_tree_augment_list_t *list = list_tree_augment_of(first)->list;
+
+  if (list->first == first)
+  {
+    list->hash = hash;
+    list->hasher = context->hasher;
+  }
+}
+
+/*
+  Hash the list starting from first, and each node of its tree
+  whose hash is not known yet.  A level is kept per list on the
+  way down, so the memory grows with the depth of the tree only.
+  A node with a known hash has the hashes of all nodes below it
+  known, and so does a list, so neither is entered.
+*/
+static
+size_t
+hash_list(
+    hash_context_t *context,
+    list_tree_node_t *first)
+{
+  if (NULL == first)
+    return 0;
+
+  size_t result = list_hash_known(context, first);
+
+  if (0 != result)
+    return result;
+
+  size_t capacity = 16;
+  size_t size = 1;
+  hash_level_t *levels =
+    (hash_level_t*) malloc(capacity * sizeof(hash_level_t));
+
+  assert(NULL != levels);
+
+  levels[0].first = first;
+  levels[0].node = first;
+  levels[0].hash = HASH_LIST_SEED;
+
+  for (;;)
+  {
+    hash_level_t *level = &levels[size - 1];
+    list_tree_node_t *node = level->node;
+
+    if (NULL == node)
+    {
+      size_t list_hash = hash_nonzero(level->hash);
+
+      list_hash_store(context, level->first, list_hash);
+
+      if (0 == -- size)
+      {
+        result = list_hash;
+        break;
+      }
+
+      level = &levels[size - 1];
+
+      size_t node_hash = hash_nonzero(hash_mix(level->data_hash, list_hash));
+
+      node_hash_store(context, level->node, node_hash);
+      level->hash = hash_mix(level->hash, node_hash);
+      level->node = list_tree_node_next(level->node);
+      continue;
+    }
+
+    size_t node_hash = node_hash_known(context, node);
+
+    if (0 == node_hash)
+    {
+      size_t data_hash =
+        hash_mix(HASH_NODE_SEED, context->hasher(node->data));
+      list_tree_node_t *first_child = list_tree_node_first_child(node);
+      size_t children_hash = NULL == first_child
+        ? 0
+        : list_hash_known(context, first_child);
+
+      if (NULL != first_child && 0 == children_hash)
+      {
+        level->data_hash = data_hash;
+
+        if (size == capacity)
+        {
+          capacity *= 2;
+          levels = (hash_level_t*) realloc(
+              levels,
+              capacity * sizeof(hash_level_t));
+          assert(NULL != levels);
+        }
+
+        levels[size].first = first_child;
+        levels[size].node = first_child;
+        levels[size].hash = HASH_LIST_SEED;
+        ++ size;
+        continue;
+      }
+
+      node_hash = hash_nonzero(hash_mix(data_hash, children_hash));
+      node_hash_store(context, node, node_hash);
+    }
+
+    level->hash = hash_mix(level->hash, node_hash);
+    level->node = list_tree_node_next(node);
+  }
+
+  free(levels);
+
+  return result;
+}
+
+/* Hash of the node with its children, which is known by now */
+static
+size_t
+hash_of(
+    hash_context_t const* context,
+    list_tree_node_t *node)
+{
+  if (NULL == node)
+    return 0;
+
+  size_t hash = node_hash_known(context, node);
+
+  assert(0 != hash);
+
+  return hash;
+}
+
+static
+void
+hash_context_init(
+    hash_context_t *context,
+    data_hasher_t hasher)
+{
+  assert(NULL != hasher);
+
+  context->hasher = hasher;
+  list_tree_map_init(&context->map);
+}
+
+static
+void
+pair_push(
+    pair_frame_t **frames,
+    size_t *size,
+    size_t *capacity,
+    list_tree_node_t *a,
+    list_tree_node_t *b,
+    size_t depth,
+    size_t index)
+{
+  if (*size == *capacity)
+  {
+    *capacity = 0 == *capacity ? 16 : 2 * *capacity;
+    *frames = (pair_frame_t*) realloc(
+        *frames,
+        *capacity * sizeof(pair_frame_t));
+    assert(NULL != *frames);
+  }
+
+  (*frames)[*size].a = a;
+  (*frames)[*size].b = b;
+  (*frames)[*size].depth = depth;
+  (*frames)[*size].index = index;
+  ++ *size;
+}
+
+size_t
+list_tree_hash(
+    list_tree_node_t *root,
+    data_hasher_t hasher)
+{
+  hash_context_t context;
+
+  hash_context_init(&context, hasher);
+
+  size_t hash = hash_list(&context, root);
+
+  list_tree_map_dispose(&context.map);
+
+  return hash;
+}
+
+/* The hashes of the lists and nodes above the node depend on it */
+void
+list_tree_hash_invalidate(
+    list_tree_node_t *node)
+{
+  assert(NULL != node);
+  assert(0 != (node->flags & NODE_AUGMENTED));
+
+  while (NULL != node)
+  {
+    list_tree_augment_t *augment = list_tree_augment_of(node);
+
+    augment->hasher = NULL;
+    augment->list->hasher = NULL;
+    node = augment->list->parent;
+  }
+}
+
+/*
+  Only augmented trees have their hashes cached, so only for them
+  comparing the hashes first can save work.  Other trees are
+  walked in lockstep, stopping at the first difference, which
+  costs no more than hashing them would.  Pairs of next nodes wait
+  on the stack under pairs of first children, so the stack grows
+  with the depth of the trees only.
+*/
+int
+list_tree_equal(
+    list_tree_node_t *a,
+    list_tree_node_t *b,
+    data_hasher_t hasher,
+    predicate_t comparer)
+{
+  assert(NULL != hasher);
+
+  if (a == b)
+    return 1;
+
+  int is_equal = 1;
+
+  if (NULL != a && NULL != b &&
+      0 != (a->flags & NODE_AUGMENTED) &&
+      0 != (b->flags & NODE_AUGMENTED))
+  {
+    hash_context_t context;
+
+    hash_context_init(&context, hasher);
+    is_equal = hash_list(&context, a) == hash_list(&context, b);
+    list_tree_map_dispose(&context.map);
+
+    if (!is_equal || NULL == comparer)
+      return is_equal;
+  }
+
+  pair_frame_t *frames = NULL;
+  size_t size = 0;
+  size_t capacity = 0;
+
+  pair_push(&frames, &size, &capacity, a, b, 0, 0);
+
+  while (is_equal && 0 != size)
+  {
+    pair_frame_t frame = frames[-- size];
+
+    if (frame.a == frame.b)
+      continue;
+
+    if (NULL == frame.a || NULL == frame.b ||
+        (NULL == comparer
+         ? hasher(frame.a->data) != hasher(frame.b->data)
+         : !comparer(frame.a->data, frame.b->data)))
+    {
+      is_equal = 0;
+      break;
+    }
+
+    pair_push(
+        &frames,
+        &size,
+        &capacity,
+        list_tree_node_next(frame.a),
+        list_tree_node_next(frame.b),
+        0,
+        0);
+    pair_push(
+        &frames,
+        &size,
+        &capacity,
+        list_tree_node_first_child(frame.a),
+        list_tree_node_first_child(frame.b),
+        0,
+        0);
+  }
+
+  free(frames);
+
+  return is_equal;
+}
+
+/*
+  Same walk as in list_tree_equal, not entering pairs of nodes with
+  equal hashes, and skipping pairs of lists with equal cached
+  hashes altogether.  The path of a pair is kept in an array overwritten at
+  its depth: everything above was set by its ancestors, which are
+  popped before it, and what its earlier siblings wrote deeper is
+  cut off by the path length.
+*/
+void
+list_tree_diff(
+    list_tree_node_t *a,
+    list_tree_node_t *b,
+    data_hasher_t hasher,
+    list_tree_diff_visitor_t visitor,
+    void *state)
+{
+  assert(NULL != visitor);
+
+  hash_context_t context;
+
+  hash_context_init(&context, hasher);
+
+  if (hash_list(&context, a) == hash_list(&context, b))
+  {
+    list_tree_map_dispose(&context.map);
+    return;
+  }
+
+  pair_frame_t *frames = NULL;
+  size_t size = 0;
+  size_t capacity = 0;
+  size_t *path = NULL;
+  size_t path_capacity = 0;
+  int is_stopped = 0;
+
+  pair_push(&frames, &size, &capacity, a, b, 0, 0);
+
+  while (!is_stopped && 0 != size)
+  {
+    pair_frame_t frame = frames[-- size];
+
+    if (0 == frame.index && NULL != frame.a && NULL != frame.b)
+    {
+      size_t list_hash = list_hash_known(&context, frame.a);
+
+      if (0 != list_hash && list_hash == list_hash_known(&context, frame.b))
+        continue;
+    }
+
+    if (NULL != frame.a || NULL != frame.b)
+    {
+      pair_push(
+          &frames,
+          &size,
+          &capacity,
+          NULL == frame.a ? NULL : list_tree_node_next(frame.a),
+          NULL == frame.b ? NULL : list_tree_node_next(frame.b),
+          frame.depth,
+          frame.index + 1);
+    }
+
+    if (hash_of(&context, frame.a) == hash_of(&context, frame.b))
+      continue;
+
+    if (frame.depth == path_capacity)
+    {
+      path_capacity = 0 == path_capacity ? 16 : 2 * path_capacity;
+      path = (size_t*) realloc(path, path_capacity * sizeof(size_t));
+      assert(NULL != path);
+    }
+
+    path[frame.depth] = frame.index;
+
+    if (NULL == frame.a || NULL == frame.b)
+    {
+      is_stopped = !visitor(path, frame.depth + 1, frame.a, frame.b, state);
+      continue;
+    }
+
+    if (hasher(frame.a->data) != hasher(frame.b->data))
+      is_stopped = !visitor(path, frame.depth + 1, frame.a, frame.b, state);
+
+    pair_push(
+        &frames,
+        &size,
+        &capacity,
+        list_tree_node_first_child(frame.a),
+        list_tree_node_first_child(frame.b),
+        frame.depth + 1,
+        0);
+  }
+
+  free(path);
+  free(frames);
+  list_tree_map_dispose(&context.map);
+}
@@ -0,0 +1,103 @@
+/*
+   Structural hashing, equality and difference of list-trees.
+
+   The hash of a node is built from the hash of its data, given by
+   a data hasher, and the hash of the list of its children; the
+   hash of a list, from the hashes of its nodes in order.  Equal
+   hashes of two trees thus mean, up to a collision, that they have
+   the same shape and data.  The empty tree has the hash 0, and no
+   other tree has it.
+
+   Augmented nodes (see list_tree_make_augmented) cache their
+   hashes, and augmented lists those of whole lists.  The modifiers
+   of list_tree.h drop the cached hashes of the nodes and lists
+   above the change, so that rehashing a modified tree costs the
+   length of the lists on the paths to the modifications rather
+   than the size of the tree.  These savings hold for augmented
+   trees only: plain, lazy and shared nodes have no room for a
+   cache, so every call hashing or diffing them visits the whole
+   trees again.
+
+   Hashing writes to the caches, so it must not run concurrently
+   with other hashing or modification of the same augmented tree.
+
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#ifndef _LIST_TREE_HASH_H_
+#define _LIST_TREE_HASH_H_
+
+#include "list_tree.h"
+
+/*
+  Callback on a node present in at most one of two trees or having
+  different data in them, at the given path of indices as taken
+  by list_tree_locate.  A node missing from a tree is NULL.  The
+  path is only valid during the call.  Returns false (0) to stop.
+*/
+typedef
+  int
+  (*list_tree_diff_visitor_t)(
+      size_t const* path,
+      size_t path_length,
+      list_tree_node_t *a,
+      list_tree_node_t *b,
+      void *state);
+
+/* Hash of the tree starting from root, i.e. with its next nodes */
+size_t
+list_tree_hash(
+    list_tree_node_t *root,
+    data_hasher_t hasher);
+
+/*
+  Drop the cached hashes after the data of an augmented node, or
+  data pointed to by it, has been changed in place.  There is no
+  need to call it after the modifiers of list_tree.h.
+*/
+void
+list_tree_hash_invalidate(
+    list_tree_node_t *node);
+
+/*
+  Whether two trees have the same shape and equal data in the
+  same places.  Data are compared by comparer, called on the data
+  of a node of a and of the corresponding node of b and returning
+  true (non-0) if they are equal, or by their hashes if comparer
+  is NULL.  Subtrees shared by both trees are skipped.
+
+  Augmented trees are first told apart by their hashes, which
+  costs nothing once cached; if comparer is NULL, equal hashes are
+  taken for equal trees.  Other trees are compared node by node
+  up to the first difference, without hashing the rest.
+*/
+int
+list_tree_equal(
+    list_tree_node_t *a,
+    list_tree_node_t *b,
+    data_hasher_t hasher,
+    predicate_t comparer);
+
+/*
+  Call visitor on every node that differs between two trees, in
+  pre-order.  Nodes are matched by their paths.  A subtree present
+  in one tree only is reported by its root alone, and nodes of a
+  list that continues in one tree only are reported one by one.
+
+  Matched nodes whose hashes are equal are taken for equal with
+  their children and not entered, as well as data with equal
+  hashes.  For augmented trees with cached hashes, whole lists are
+  skipped the same way, so the cost grows with the lengths of the
+  lists on the paths to the differences, not with the size of the
+  trees.  Other trees are hashed in full by every call.
+*/
+void
+list_tree_diff(
+    list_tree_node_t *a,
+    list_tree_node_t *b,
+    data_hasher_t hasher,
+    list_tree_diff_visitor_t visitor,
+    void *state);
+
+#endif
@@ -0,0 +1,278 @@
+/*
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include "list_tree.h"
+#include "list_tree_lazy.h"
+#include "list_tree_node.h"
+
+/* Generate the node at the path, NULL if there is no such node */
+static
+list_tree_node_t*
+lazy_make(
+    list_tree_lazy_tree_t *tree,
+    size_t index,
+    path_item_t const* prev)
+{
+  path_item_t item = { index, prev };
+  void *data;
+
+  if (!tree->generator(&item, tree->state, &data))
+    return NULL;
+
+  list_tree_lazy_t *lazy = (list_tree_lazy_t*) malloc(
+      sizeof(list_tree_lazy_t) + sizeof(list_tree_node_t));
+
+  assert(NULL != lazy);
+
+  list_tree_node_t *node = (list_tree_node_t*) (lazy + 1);
+
+  node->data = data;
+  node->next = NULL;
+  node->first_child = NULL;
+  node->flags = NODE_LAZY | NODE_CHILD_PENDING | NODE_NEXT_PENDING;
+  lazy->tree = tree;
+  lazy->stamp = ++ tree->clock;
+  lazy->item = item;
+  ++ tree->count;
+
+  return node;
+}
+
+void
+list_tree_lazy_touch(
+    list_tree_node_t *node,
+    unsigned pending)
+{
+  list_tree_lazy_t *lazy = list_tree_lazy_of(node);
+  list_tree_lazy_tree_t *tree = lazy->tree;
+
+  lazy->stamp = ++ tree->clock;
+  pending &= node->flags;
+
+  if (0 != (pending & NODE_CHILD_PENDING))
+    node->first_child = lazy_make(tree, 0, &lazy->item);
+
+  if (0 != (pending & NODE_NEXT_PENDING))
+    node->next = lazy_make(tree, lazy->item.index + 1, lazy->item.prev);
+
+  node->flags &= ~pending;
+}
+
+void
+list_tree_lazy_free(
+    list_tree_node_t *node)
+{
+  list_tree_lazy_t *lazy = list_tree_lazy_of(node);
+  list_tree_lazy_tree_t *tree = lazy->tree;
+
+  free(lazy);
+
+  if (0 == -- tree->count)
+    free(tree);
+}
+
+list_tree_node_t*
+list_tree_generate_lazy(
+    node_generator_t generator,
+    void *state)
+{
+  assert(NULL != generator);
+
+  list_tree_lazy_tree_t *tree = (list_tree_lazy_tree_t*) malloc(
+      sizeof(list_tree_lazy_tree_t));
+
+  assert(NULL != tree);
+
+  tree->generator = generator;
+  tree->state = state;
+  tree->count = 0;
+  tree->clock = 0;
+
+  list_tree_node_t *root = lazy_make(tree, 0, NULL);
+
+  if (NULL == root)
+    free(tree);
+
+  return root;
+}
+
+size_t
+list_tree_lazy_count(
+    list_tree_node_t *root)
+{
+  assert(NULL != root);
+  assert(0 != (root->flags & NODE_LAZY));
+
+  return list_tree_lazy_of(root)->tree->count;
+}
+
+/* A node whose children may be trimmed, with their heat */
+typedef struct _trim_candidate_t
+{
+  list_tree_node_t *node;
+  unsigned long stamp;
+  size_t depth;
+} trim_candidate_t;
+
+/*
+  The least recent subtrees go first.  A subtree is never more
+  recent than the subtree containing it, and on a tie the deeper
+  one goes first, so nested subtrees are trimmed from inside.
+*/
+static
+int
+trim_candidate_compare(
+    void const* raw_left,
+    void const* raw_right)
+{
+  trim_candidate_t const* left = (trim_candidate_t const*) raw_left;
+  trim_candidate_t const* right = (trim_candidate_t const*) raw_right;
+
+  if (left->stamp != right->stamp)
+    return left->stamp < right->stamp ? -1 : 1;
+
+  if (left->depth != right->depth)
+    return left->depth > right->depth ? -1 : 1;
+
+  return 0;
+}
+
+/*
+  The existing nodes are listed in depth-first order without
+  generating anything, each with the position of its parent.  In
+  the reverse order, descendants come before their ancestors, so
+  a single backward pass collects the last access to the subtrees
+  of the children of each node, its heat.  Passing by a node does
+  not warm up its children.
+*/
+size_t
+list_tree_lazy_trim(
+    list_tree_node_t *root,
+    size_t budget,
+    data_disposer_t data_disposer)
+{
+  list_tree_lazy_tree_t *tree = list_tree_lazy_of(root)->tree;
+
+  if (tree->count <= budget)
+    return tree->count;
+
+  size_t count = tree->count;
+  list_tree_node_t **nodes = (list_tree_node_t**) malloc(
+      count * sizeof(list_tree_node_t*));
+  size_t *parents = (size_t*) malloc(count * sizeof(size_t));
+  unsigned long *stamps = (unsigned long*) malloc(
+      count * sizeof(unsigned long));
+  unsigned long *heats = (unsigned long*) calloc(
+      count,
+      sizeof(unsigned long));
+  trim_candidate_t *candidates = (trim_candidate_t*) malloc(
+      count * sizeof(trim_candidate_t));
+
+  assert(NULL != nodes);
+  assert(NULL != parents);
+  assert(NULL != stamps);
+  assert(NULL != heats);
+  assert(NULL != candidates);
+
+  /* Pending lists of the walk are kept as (head, parent) pairs */
+  size_t *pending_parents = (size_t*) malloc(count * sizeof(size_t));
+  list_tree_node_t **pending = (list_tree_node_t**) malloc(
+      count * sizeof(list_tree_node_t*));
+  size_t pending_size = 0;
+  size_t size = 0;
+
+  assert(NULL != pending_parents);
+  assert(NULL != pending);
+
+  pending[pending_size] = root;
+  pending_parents[pending_size ++] = count;
+
+  while (0 != pending_size)
+  {
+    -- pending_size;
+
+    list_tree_node_t *node = pending[pending_size];
+    size_t parent = pending_parents[pending_size];
+
+    nodes[size] = node;
+    parents[size] = parent;
+    stamps[size] = list_tree_lazy_of(node)->stamp;
+
+    if (NULL != node->next)
+    {
+      pending[pending_size] = node->next;
+      pending_parents[pending_size ++] = parent;
+    }
+
+    if (NULL != node->first_child)
+    {
+      pending[pending_size] = node->first_child;
+      pending_parents[pending_size ++] = size;
+    }
+
+    ++ size;
+  }
+
+  free(pending);
+  free(pending_parents);
+
+  assert(size == count);
+
+  size_t candidate_count = 0;
+
+  for (size_t i = size; 0 != i; -- i)
+  {
+    size_t parent = parents[i - 1];
+    unsigned long stamp = stamps[i - 1] < heats[i - 1]
+      ? heats[i - 1]
+      : stamps[i - 1];
+
+    if (count != parent && heats[parent] < stamp)
+      heats[parent] = stamp;
+  }
+
+  /* The depth of a parent is known before its children */
+  size_t *depths = parents;
+
+  for (size_t i = 0; i < size; ++i)
+  {
+    size_t parent = parents[i];
+    depths[i] = count == parent ? 0 : depths[parent] + 1;
+
+    if (NULL != nodes[i]->first_child)
+    {
+      trim_candidate_t *candidate = &candidates[candidate_count ++];
+
+      candidate->node = nodes[i];
+      candidate->stamp = heats[i];
+      candidate->depth = depths[i];
+    }
+  }
+
+  qsort(
+      candidates,
+      candidate_count,
+      sizeof(trim_candidate_t),
+      trim_candidate_compare);
+
+  for (size_t i = 0; i < candidate_count && tree->count > budget; ++i)
+  {
+    list_tree_node_t *node = candidates[i].node;
+
+    list_tree_dispose(node->first_child, data_disposer);
+    node->first_child = NULL;
+    node->flags |= NODE_CHILD_PENDING;
+  }
+
+  free(candidates);
+  free(heats);
+  free(stamps);
+  free(parents);
+  free(nodes);
+
+  return tree->count;
+}
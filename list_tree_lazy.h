@@ -0,0 +1,53 @@
+/*
+   Lazy list-trees.
+
+   A lazy tree is generated from a node generator piece by piece:
+   the first child and the next node of a node are only generated
+   when they are first read through the getters, a traversal, a
+   cursor or list_tree_locate.  Huge virtual trees thus take memory
+   proportional to the part that is actually visited.  Visiting a
+   node with a traversal generates its first child, if any, to
+   tell whether there is a subtree to descend into.
+
+   The generator is called again to regenerate parts of the tree
+   that have been trimmed away, so it must give the same data for
+   the same path, and its state must live as long as the tree.
+
+   Lazy trees must not be modified, nor passed to the parallel
+   functions, which only see the nodes generated so far.  They are
+   disposed with list_tree_dispose as usual, without generating
+   the rest of them.
+
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#ifndef _LIST_TREE_LAZY_H_
+#define _LIST_TREE_LAZY_H_
+
+#include "list_tree.h"
+
+/* Generate the root node only; NULL if the tree is empty */
+list_tree_node_t*
+list_tree_generate_lazy(
+    node_generator_t generator,
+    void *state);
+
+/* Number of nodes of the whole tree that exist at the moment */
+size_t
+list_tree_lazy_count(
+    list_tree_node_t *root);
+
+/*
+  Dispose the subtrees that have been accessed least recently
+  until at most budget nodes exist, or only the root list is left.
+  The subtrees are regenerated on the next access, so pointers to
+  their nodes become invalid.  Returns the number of nodes left.
+*/
+size_t
+list_tree_lazy_trim(
+    list_tree_node_t *root,
+    size_t budget,
+    data_disposer_t data_disposer);
+
+#endif
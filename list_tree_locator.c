@@ -0,0 +1,159 @@
+/*
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include "list_tree.h"
+#include "list_tree_locator.h"
+#include "list_tree_map.h"
+
+enum { LOCATOR_DEFAULT_MIN_WIDTH = 64 };
+
+typedef struct _jump_table_t
+{
+  size_t length;
+  list_tree_node_t *nodes[];
+} jump_table_t;
+
+struct _list_tree_locator_t
+{
+  size_t min_width;
+  list_tree_map_t tables;
+};
+
+list_tree_locator_t*
+list_tree_locator_create(
+    size_t min_width)
+{
+  list_tree_locator_t *locator =
+    (list_tree_locator_t*) malloc(sizeof(list_tree_locator_t));
+
+  assert(NULL != locator);
+
+  locator->min_width =
+    0 == min_width ? LOCATOR_DEFAULT_MIN_WIDTH : min_width;
+  list_tree_map_init(&locator->tables);
+
+  return locator;
+}
+
+static
+void
+locator_free_tables(
+    list_tree_locator_t *locator)
+{
+  list_tree_map_t *tables = &locator->tables;
+
+  for (size_t i = 0; i < tables->capacity; ++i)
+  {
+    if (NULL != tables->keys[i])
+      free(tables->values[i]);
+  }
+}
+
+void
+list_tree_locator_dispose(
+    list_tree_locator_t *locator)
+{
+  assert(NULL != locator);
+
+  locator_free_tables(locator);
+  list_tree_map_dispose(&locator->tables);
+  free(locator);
+}
+
+void
+list_tree_locator_reset(
+    list_tree_locator_t *locator)
+{
+  assert(NULL != locator);
+
+  locator_free_tables(locator);
+  list_tree_map_clear(&locator->tables);
+}
+
+static
+jump_table_t*
+jump_table_make(
+    list_tree_node_t *first)
+{
+  size_t length = list_tree_length(first);
+  jump_table_t *table = (jump_table_t*) malloc(
+      sizeof(jump_table_t) + length * sizeof(list_tree_node_t*));
+
+  assert(NULL != table);
+
+  table->length = length;
+
+  list_tree_node_t *node = first;
+  for (size_t i = 0; i < length; ++i)
+  {
+    table->nodes[i] = node;
+    node = list_tree_get_next(node);
+  }
+
+  return table;
+}
+
+/*
+  Return the node at the index in the list starting with first.
+  A list gets a jump table as soon as the walk along it reaches
+  the minimal width.
+*/
+static
+list_tree_node_t*
+locator_nth(
+    list_tree_locator_t *locator,
+    list_tree_node_t *first,
+    size_t index)
+{
+  jump_table_t *table =
+    (jump_table_t*) list_tree_map_get(&locator->tables, first);
+
+  if (NULL != table)
+    return index < table->length ? table->nodes[index] : NULL;
+
+  if (index < locator->min_width)
+  {
+    list_tree_node_t *node = first;
+
+    for (size_t i = index; 0 != i && NULL != node; --i)
+      node = list_tree_get_next(node);
+
+    return node;
+  }
+
+  table = jump_table_make(first);
+  list_tree_map_put(&locator->tables, first, table);
+
+  return index < table->length ? table->nodes[index] : NULL;
+}
+
+list_tree_node_t*
+list_tree_locator_locate(
+    list_tree_locator_t *locator,
+    list_tree_node_t *root,
+    size_t const* path,
+    size_t path_length)
+{
+  assert(NULL != locator);
+
+  if (0 == path_length)
+    return NULL;
+
+  list_tree_node_t *node = root;
+
+  for (size_t level = 0; NULL != node; ++level)
+  {
+    node = locator_nth(locator, node, path[level]);
+
+    if (NULL == node || level + 1 == path_length)
+      break;
+
+    node = list_tree_get_first_child(node);
+  }
+
+  return node;
+}
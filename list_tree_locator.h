@@ -0,0 +1,51 @@
+/*
+   Locating nodes in wide lists.
+
+   A locator remembers a jump table for each list it had to walk
+   far enough while locating nodes, so that next time the k-th
+   node of that list is found in constant time instead of k steps.
+   Narrow lists are walked as usual and cost no memory.
+
+   Jump tables are not updated when the tree changes: after adding
+   or removing nodes of a list the locator has been used on, call
+   list_tree_locator_reset.
+
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#ifndef _LIST_TREE_LOCATOR_H_
+#define _LIST_TREE_LOCATOR_H_
+
+#include "list_tree.h"
+
+typedef
+  struct _list_tree_locator_t
+  list_tree_locator_t;
+
+/*
+  Create a locator indexing lists once a walk along them takes at
+  least min_width steps; 0 selects a default.
+*/
+list_tree_locator_t*
+list_tree_locator_create(
+    size_t min_width);
+
+void
+list_tree_locator_dispose(
+    list_tree_locator_t *locator);
+
+/* Forget all jump tables */
+void
+list_tree_locator_reset(
+    list_tree_locator_t *locator);
+
+/* Same as list_tree_locate */
+list_tree_node_t*
+list_tree_locator_locate(
+    list_tree_locator_t *locator,
+    list_tree_node_t *root,
+    size_t const* path,
+    size_t path_length);
+
+#endif
@@ -0,0 +1,127 @@
+/*
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "list_tree_map.h"
+
+enum { MAP_INITIAL_CAPACITY = 16 };
+
+static
+size_t
+map_slot(
+    void const* key,
+    size_t capacity)
+{
+  uint64_t hash = (uint64_t) (uintptr_t) key * 0x9E3779B97F4A7C15ULL;
+
+  return (size_t) (hash >> 32) & (capacity - 1);
+}
+
+static
+void
+map_allocate(
+    list_tree_map_t *map,
+    size_t capacity)
+{
+  map->keys = (void const**) calloc(capacity, sizeof(void const*));
+  map->values = (void**) malloc(capacity * sizeof(void*));
+  map->size = 0;
+  map->capacity = capacity;
+
+  assert(NULL != map->keys);
+  assert(NULL != map->values);
+}
+
+void
+list_tree_map_init(
+    list_tree_map_t *map)
+{
+  map_allocate(map, MAP_INITIAL_CAPACITY);
+}
+
+void
+list_tree_map_dispose(
+    list_tree_map_t *map)
+{
+  free(map->keys);
+  free(map->values);
+}
+
+void
+list_tree_map_clear(
+    list_tree_map_t *map)
+{
+  memset(map->keys, 0, map->capacity * sizeof(void const*));
+  map->size = 0;
+}
+
+void*
+list_tree_map_get(
+    list_tree_map_t const* map,
+    void const* key)
+{
+  assert(NULL != key);
+
+  size_t mask = map->capacity - 1;
+
+  for (size_t i = map_slot(key, map->capacity); ; i = (i + 1) & mask)
+  {
+    if (key == map->keys[i])
+      return map->values[i];
+
+    if (NULL == map->keys[i])
+      return NULL;
+  }
+}
+
+static
+void
+map_grow(
+    list_tree_map_t *map)
+{
+  void const** keys = map->keys;
+  void **values = map->values;
+  size_t capacity = map->capacity;
+
+  map_allocate(map, 2 * capacity);
+
+  for (size_t i = 0; i < capacity; ++i)
+  {
+    if (NULL != keys[i])
+      list_tree_map_put(map, keys[i], values[i]);
+  }
+
+  free(keys);
+  free(values);
+}
+
+void
+list_tree_map_put(
+    list_tree_map_t *map,
+    void const* key,
+    void *value)
+{
+  assert(NULL != key);
+
+  if (2 * (map->size + 1) > map->capacity)
+    map_grow(map);
+
+  size_t mask = map->capacity - 1;
+  size_t i = map_slot(key, map->capacity);
+
+  while (NULL != map->keys[i] && key != map->keys[i])
+    i = (i + 1) & mask;
+
+  if (NULL == map->keys[i])
+  {
+    map->keys[i] = key;
+    ++ map->size;
+  }
+
+  map->values[i] = value;
+}
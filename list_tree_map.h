@@ -0,0 +1,46 @@
+/*
+   Hash map from pointers to pointers with open addressing, used
+   internally to attach auxiliary data to nodes without changing
+   their layout.
+*/
+
+#ifndef _LIST_TREE_MAP_H_
+#define _LIST_TREE_MAP_H_
+
+#include <stdlib.h>
+
+typedef struct _list_tree_map_t
+{
+  void const** keys;
+  void **values;
+  size_t size;
+  size_t capacity;
+} list_tree_map_t;
+
+void
+list_tree_map_init(
+    list_tree_map_t *map);
+
+void
+list_tree_map_dispose(
+    list_tree_map_t *map);
+
+/* Remove all entries, keeping the memory */
+void
+list_tree_map_clear(
+    list_tree_map_t *map);
+
+/* Return the value stored for the key, or NULL */
+void*
+list_tree_map_get(
+    list_tree_map_t const* map,
+    void const* key);
+
+/* Store a value for a non-NULL key, replacing the old one */
+void
+list_tree_map_put(
+    list_tree_map_t *map,
+    void const* key,
+    void *value);
+
+#endif
@@ -0,0 +1,263 @@
+/*
+   Layout of a list-tree node.  This header is private to the
+   library: applications see list_tree_node_t as an opaque type
+   and access it through the getters declared in list_tree.h.
+*/
+
+#ifndef _LIST_TREE_NODE_H_
+#define _LIST_TREE_NODE_H_
+
+#include <string.h>
+#include "list_tree.h"
+#include "list_tree_arena.h"
+
+struct _list_tree_node_t {
+  void *data;
+  list_tree_node_t *next;
+  list_tree_node_t *first_child;
+  unsigned flags;
+};
+
+/*
+  Variants of nodes, combined in the flags field.  A lazy node may
+  have its first child or next node still to be generated, as told
+  by the pending bits.  An arena node belongs to an arena and is
+  only freed with it.
+*/
+enum
+{
+  NODE_AUGMENTED = 1,
+  NODE_LAZY = 2,
+  NODE_CHILD_PENDING = 4,
+  NODE_NEXT_PENDING = 8,
+  NODE_INLINE = 16,
+  NODE_SHARED = 32,
+  NODE_ARENA = 64
+};
+
+/*
+  Metadata shared by the nodes of an augmented list: the node whose
+  children they are (NULL for a root list), the first of them, the
+  number of nodes referring to it, and the size and height of the
+  list with the subtrees of its nodes.  Hash is that of the list
+  as computed with hasher, or unknown if hasher is NULL, see
+  list_tree_hash.h.
+*/
+typedef struct _list_tree_augment_list_t
+{
+  list_tree_node_t *parent;
+  list_tree_node_t *first;
+  size_t count;
+  size_t size;
+  size_t height;
+  data_hasher_t hasher;
+  size_t hash;
+} list_tree_augment_list_t;
+
+/*
+  Metadata of an augmented node, allocated right before the node
+  itself: its list, and the size, height and hash of the node with
+  its children, but without its next nodes.
+*/
+typedef struct _list_tree_augment_t
+{
+  list_tree_augment_list_t *list;
+  size_t size;
+  size_t height;
+  data_hasher_t hasher;
+  size_t hash;
+} list_tree_augment_t;
+
+static inline
+list_tree_augment_t*
+list_tree_augment_of(
+    list_tree_node_t const* node)
+{
+  return (list_tree_augment_t*) node - 1;
+}
+
+/*
+  An inline node is followed by its payload in the same block of
+  memory, and its data points there.
+*/
+typedef struct _list_tree_inline_t
+{
+  list_tree_node_t node;
+  unsigned char payload[];
+} list_tree_inline_t;
+
+/* Bytes taken by an inline node, rounded to keep payloads aligned */
+static inline
+size_t
+list_tree_inline_size(
+    size_t payload_size)
+{
+  size_t size = sizeof(list_tree_inline_t) + payload_size;
+
+  return (size + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+}
+
+/* Set up a node allocated with list_tree_inline_size bytes */
+static inline
+list_tree_node_t*
+list_tree_inline_init(
+    list_tree_node_t *node,
+    void const* payload,
+    size_t payload_size,
+    list_tree_node_t *next,
+    list_tree_node_t *first_child)
+{
+  unsigned char *own_payload = ((list_tree_inline_t*) node)->payload;
+
+  if (NULL == payload)
+    memset(own_payload, 0, payload_size);
+  else
+    memcpy(own_payload, payload, payload_size);
+
+  node->data = own_payload;
+  node->next = next;
+  node->first_child = first_child;
+  node->flags = NODE_INLINE;
+
+  return node;
+}
+
+/*
+  Header of a node of persistent trees, allocated right before the
+  node itself: the number of links, roots and snapshots leading to
+  the node, changed atomically.
+*/
+typedef struct _list_tree_shared_t
+{
+  size_t references;
+} list_tree_shared_t;
+
+static inline
+list_tree_shared_t*
+list_tree_shared_of(
+    list_tree_node_t const* node)
+{
+  return (list_tree_shared_t*) node - 1;
+}
+
+/*
+  A lazy tree is a generator with its state, shared by all lazy
+  nodes generated from it.  Count is the number of nodes existing
+  at the moment, and the clock orders accesses to them.
+*/
+typedef struct _list_tree_lazy_tree_t
+{
+  node_generator_t generator;
+  void *state;
+  size_t count;
+  unsigned long clock;
+} list_tree_lazy_tree_t;
+
+/*
+  Header of a lazy node, allocated right before the node itself.
+  The path item links to that of the parent, so that the path of
+  any node is at hand to generate its first child or next node.
+  Stamp is the clock of the last access to the node.
+*/
+typedef struct _list_tree_lazy_t
+{
+  list_tree_lazy_tree_t *tree;
+  unsigned long stamp;
+  path_item_t item;
+} list_tree_lazy_t;
+
+static inline
+list_tree_lazy_t*
+list_tree_lazy_of(
+    list_tree_node_t const* node)
+{
+  return (list_tree_lazy_t*) node - 1;
+}
+
+/*
+  Record an access to a lazy node and generate its links given by
+  the pending bits, if they are still pending.
+*/
+void
+list_tree_lazy_touch(
+    list_tree_node_t *node,
+    unsigned pending);
+
+/*
+  Links of a node as seen by the library: reading them through
+  these accessors generates the pending parts of lazy trees.
+  Other nodes only pay for a test of the flags.
+
+  The loads pair with the release of the concurrent modifiers,
+  so a node reached through them is seen fully initialised.
+*/
+static inline
+list_tree_node_t*
+list_tree_node_next(
+    list_tree_node_t *node)
+{
+  if (0 != (node->flags & NODE_LAZY))
+    list_tree_lazy_touch(node, NODE_NEXT_PENDING);
+
+  return __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+}
+
+static inline
+list_tree_node_t*
+list_tree_node_first_child(
+    list_tree_node_t *node)
+{
+  if (0 != (node->flags & NODE_LAZY))
+    list_tree_lazy_touch(node, NODE_CHILD_PENDING);
+
+  return __atomic_load_n(&node->first_child, __ATOMIC_ACQUIRE);
+}
+
+/* Free the memory of a lazy node, and of its tree with the last node */
+void
+list_tree_lazy_free(
+    list_tree_node_t *node);
+
+/*
+  Free the tree at *root with its data in at most budget steps,
+  storing what is left of it back, and return the number of steps
+  taken.  A step either frees a node or moves a child up into the
+  list of its parent, so a tree of n nodes takes less than 2n steps.
+  Uses no memory besides the tree itself.
+*/
+size_t
+list_tree_free_nodes(
+    list_tree_node_t **root,
+    data_disposer_t disposer,
+    size_t budget);
+
+/* Free the memory of a single heap-allocated node of any variant */
+void
+list_tree_node_free(
+    list_tree_node_t *node);
+
+/*
+  Generate a list together with its subtrees, the parent of the
+  list being at parent_path (NULL for the root list), and store
+  its first node to *slot.  The generator is called in the same
+  order as by list_tree_generate.
+*/
+void
+list_tree_generate_list(
+    list_tree_arena_t *arena,
+    node_generator_t generator,
+    void *state,
+    path_item_t const* parent_path,
+    list_tree_node_t **slot);
+
+/* Same with an extended generator; parent_data is NULL at the root */
+void
+list_tree_generate_list_ex(
+    list_tree_arena_t *arena,
+    node_generator_ex_t generator,
+    void *state,
+    path_item_t const* parent_path,
+    void *parent_data,
+    list_tree_node_t **slot);
+
+#endif
@@ -0,0 +1,714 @@
+/*
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "list_tree.h"
+#include "list_tree_arena.h"
+#include "list_tree_node.h"
+#include "list_tree_parallel.h"
+
+typedef struct _parallel_task_t
+{
+  list_tree_node_t *node;
+  size_t depth;
+} parallel_task_t;
+
+/*
+  Tasks a worker has yet to do, a node with its next nodes each.
+  The worker pops them at the top, going depth-first; entries
+  below base have been handed over to the pool.
+*/
+typedef struct _task_stack_t
+{
+  parallel_task_t *tasks;
+  size_t base;
+  size_t size;
+  size_t capacity;
+} task_stack_t;
+
+typedef struct _parallel_pool_t parallel_pool_t;
+
+typedef struct _parallel_worker_t
+{
+  parallel_pool_t *pool;
+  task_stack_t stack;
+  void *state;
+} parallel_worker_t;
+
+/*
+  Shared tasks are kept in a stack of the pool under its lock.
+  Pending counts the shared tasks and those being run; idle, the
+  workers waiting for a task, which is what busy workers check
+  before sharing anything.
+*/
+struct _parallel_pool_t
+{
+  pthread_mutex_t lock;
+  pthread_cond_t has_work;
+  task_stack_t shared;
+  list_tree_parallel_visitor_t visitor;
+  size_t pending;
+  size_t idle;
+  int is_stopped;
+};
+
+static
+void
+task_stack_init(
+    task_stack_t *stack)
+{
+  stack->capacity = 64;
+  stack->tasks = (parallel_task_t*) malloc(
+      stack->capacity * sizeof(parallel_task_t));
+  stack->base = 0;
+  stack->size = 0;
+
+  assert(NULL != stack->tasks);
+}
+
+static
+void
+task_stack_push(
+    task_stack_t *stack,
+    list_tree_node_t *node,
+    size_t depth)
+{
+  if (stack->size == stack->capacity)
+  {
+    stack->capacity *= 2;
+    stack->tasks = (parallel_task_t*) realloc(
+        stack->tasks,
+        stack->capacity * sizeof(parallel_task_t));
+
+    assert(NULL != stack->tasks);
+  }
+
+  stack->tasks[stack->size].node = node;
+  stack->tasks[stack->size].depth = depth;
+  ++ stack->size;
+}
+
+/* Stop the traversal and wake up the waiting workers */
+static
+void
+parallel_stop(
+    parallel_pool_t *pool)
+{
+  pthread_mutex_lock(&pool->lock);
+  __atomic_store_n(&pool->is_stopped, 1, __ATOMIC_RELAXED);
+  pthread_cond_broadcast(&pool->has_work);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+  Hand the bottom task of the worker, i.e. the shallowest and thus
+  likely the biggest one, over to a waiting worker.
+*/
+static
+void
+parallel_share(
+    parallel_worker_t *worker)
+{
+  parallel_pool_t *pool = worker->pool;
+  task_stack_t *stack = &worker->stack;
+  parallel_task_t *task = &stack->tasks[stack->base ++];
+
+  pthread_mutex_lock(&pool->lock);
+  task_stack_push(&pool->shared, task->node, task->depth);
+  ++ pool->pending;
+  pthread_cond_signal(&pool->has_work);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+  Walk the tree from the task depth-first, following first
+  children and keeping the next nodes on the stack of the worker.
+  A task thus covers whole lists, and work is split only when
+  some worker is idle, so most nodes cost no synchronisation but
+  a relaxed load.
+*/
+static
+void
+parallel_run_task(
+    parallel_worker_t *worker,
+    parallel_task_t const* task)
+{
+  parallel_pool_t *pool = worker->pool;
+  task_stack_t *stack = &worker->stack;
+
+  stack->base = 0;
+  stack->size = 0;
+  task_stack_push(stack, task->node, task->depth);
+
+  while (stack->base != stack->size)
+  {
+    -- stack->size;
+
+    list_tree_node_t *node = stack->tasks[stack->size].node;
+    size_t depth = stack->tasks[stack->size].depth;
+
+    while (NULL != node)
+    {
+      if (__atomic_load_n(&pool->is_stopped, __ATOMIC_RELAXED))
+        return;
+
+      list_tree_node_t *next = list_tree_get_next(node);
+
+      if (NULL != next)
+        task_stack_push(stack, next, depth);
+
+      int mode = pool->visitor(node, depth, worker->state);
+
+      if (0 > mode)
+      {
+        parallel_stop(pool);
+        return;
+      }
+
+      if (stack->base != stack->size &&
+          0 != __atomic_load_n(&pool->idle, __ATOMIC_RELAXED))
+        parallel_share(worker);
+
+      node = 0 == mode ? NULL : list_tree_get_first_child(node);
+      ++ depth;
+    }
+  }
+}
+
+static
+void*
+parallel_worker_run(
+    void *raw_worker)
+{
+  parallel_worker_t *worker = (parallel_worker_t*) raw_worker;
+  parallel_pool_t *pool = worker->pool;
+
+  pthread_mutex_lock(&pool->lock);
+
+  while (!pool->is_stopped)
+  {
+    if (0 != pool->shared.size)
+    {
+      parallel_task_t task = pool->shared.tasks[-- pool->shared.size];
+
+      pthread_mutex_unlock(&pool->lock);
+      parallel_run_task(worker, &task);
+      pthread_mutex_lock(&pool->lock);
+
+      if (0 == -- pool->pending)
+        pthread_cond_broadcast(&pool->has_work);
+    }
+    else if (0 == pool->pending)
+    {
+      break;
+    }
+    else
+    {
+      __atomic_add_fetch(&pool->idle, 1, __ATOMIC_RELAXED);
+      pthread_cond_wait(&pool->has_work, &pool->lock);
+      __atomic_sub_fetch(&pool->idle, 1, __ATOMIC_RELAXED);
+    }
+  }
+
+  pthread_mutex_unlock(&pool->lock);
+
+  return NULL;
+}
+
+static
+size_t
+parallel_thread_count(
+    size_t thread_count)
+{
+  if (0 != thread_count)
+    return thread_count;
+
+  long online = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return 0 < online ? (size_t) online : 1;
+}
+
+/*
+  A thread that fails to start leaves its share to the others, as
+  tasks are taken from the pool by whoever is free.
+*/
+void
+list_tree_traverse_parallel(
+    list_tree_node_t *root,
+    size_t thread_count,
+    list_tree_parallel_visitor_t visitor,
+    void const* initial_state,
+    size_t state_size,
+    list_tree_state_merge_t merge,
+    void *result)
+{
+  assert(NULL != visitor);
+
+  if (NULL == root)
+    return;
+
+  size_t worker_count = parallel_thread_count(thread_count);
+  parallel_pool_t pool;
+
+  pthread_mutex_init(&pool.lock, NULL);
+  pthread_cond_init(&pool.has_work, NULL);
+  task_stack_init(&pool.shared);
+  task_stack_push(&pool.shared, root, 0);
+  pool.visitor = visitor;
+  pool.pending = 1;
+  pool.idle = 0;
+  pool.is_stopped = 0;
+
+  parallel_worker_t *workers = (parallel_worker_t*) malloc(
+      worker_count * sizeof(parallel_worker_t));
+  pthread_t *threads = (pthread_t*) malloc(
+      worker_count * sizeof(pthread_t));
+  int *is_started = (int*) malloc(worker_count * sizeof(int));
+
+  assert(NULL != workers);
+  assert(NULL != threads);
+  assert(NULL != is_started);
+
+  for (size_t i = 0; i < worker_count; ++i)
+  {
+    parallel_worker_t *worker = &workers[i];
+
+    worker->pool = &pool;
+    task_stack_init(&worker->stack);
+    worker->state = malloc(0 == state_size ? 1 : state_size);
+
+    assert(NULL != worker->state);
+
+    if (0 != state_size)
+      memcpy(worker->state, initial_state, state_size);
+  }
+
+  for (size_t i = 1; i < worker_count; ++i)
+  {
+    is_started[i] = 0 == pthread_create(
+        &threads[i],
+        NULL,
+        parallel_worker_run,
+        &workers[i]);
+  }
+
+  parallel_worker_run(&workers[0]);
+
+  for (size_t i = 1; i < worker_count; ++i)
+  {
+    if (is_started[i])
+      pthread_join(threads[i], NULL);
+  }
+
+  for (size_t i = 0; i < worker_count; ++i)
+  {
+    parallel_worker_t *worker = &workers[i];
+
+    if (NULL != merge)
+      merge(result, worker->state);
+
+    free(worker->stack.tasks);
+    free(worker->state);
+  }
+
+  free(is_started);
+  free(threads);
+  free(workers);
+  free(pool.shared.tasks);
+  pthread_cond_destroy(&pool.has_work);
+  pthread_mutex_destroy(&pool.lock);
+}
+
+static
+int
+parallel_size_visitor(
+    list_tree_node_t *_,
+    size_t depth,
+    void *raw_state)
+{
+  ++ *(size_t*) raw_state;
+
+  return 1;
+}
+
+static
+void
+parallel_size_merge(
+    void *raw_result,
+    void const* raw_state)
+{
+  *(size_t*) raw_result += *(size_t const*) raw_state;
+}
+
+size_t
+list_tree_size_parallel(
+    list_tree_node_t *root,
+    size_t thread_count)
+{
+  size_t initial = 0;
+  size_t result = 0;
+
+  list_tree_traverse_parallel(
+      root,
+      thread_count,
+      parallel_size_visitor,
+      &initial,
+      sizeof(size_t),
+      parallel_size_merge,
+      &result);
+
+  return result;
+}
+
+typedef struct _parallel_find_state_t
+{
+  predicate_t predicate;
+  void *predicate_param;
+  list_tree_node_t *result;
+} parallel_find_state_t;
+
+static
+int
+parallel_find_visitor(
+    list_tree_node_t *node,
+    size_t depth,
+    void *raw_state)
+{
+  parallel_find_state_t *state = (parallel_find_state_t*) raw_state;
+
+  if (!state->predicate(list_tree_get_data(node), state->predicate_param))
+    return 1;
+
+  state->result = node;
+
+  return -1;
+}
+
+static
+void
+parallel_find_merge(
+    void *raw_result,
+    void const* raw_state)
+{
+  parallel_find_state_t *result = (parallel_find_state_t*) raw_result;
+  parallel_find_state_t const* state =
+    (parallel_find_state_t const*) raw_state;
+
+  if (NULL == result->result)
+    result->result = state->result;
+}
+
+list_tree_node_t*
+list_tree_find_parallel(
+    list_tree_node_t *root,
+    predicate_t predicate,
+    void *predicate_param,
+    size_t thread_count)
+{
+  assert(NULL != predicate);
+
+  parallel_find_state_t state =
+  {
+    predicate,
+    predicate_param,
+    NULL
+  };
+
+  parallel_find_state_t result = state;
+
+  list_tree_traverse_parallel(
+      root,
+      thread_count,
+      parallel_find_visitor,
+      &state,
+      sizeof(state),
+      parallel_find_merge,
+      &result);
+
+  return result.result;
+}
+
+enum
+{
+  GENERATE_TASKS_PER_THREAD = 8,
+  GENERATE_MAX_DEPTH = 16
+};
+
+typedef struct _generate_entry_t
+{
+  list_tree_node_t *node;
+  path_item_t item;
+} generate_entry_t;
+
+/*
+  A level of the upper part of the tree, generated breadth-first.
+  Its path items refer to copies of those of the previous level,
+  which are kept until the pool is done, while the previous level
+  itself is freed as soon as this one is built.
+*/
+typedef struct _generate_level_t
+{
+  generate_entry_t *entries;
+  size_t size;
+  size_t capacity;
+} generate_level_t;
+
+typedef struct _generate_pool_t
+{
+  node_generator_t generator;
+  generate_level_t const* tasks;
+  size_t next_task;
+} generate_pool_t;
+
+typedef struct _generate_worker_t
+{
+  generate_pool_t *pool;
+  void *state;
+  list_tree_arena_t *arena;
+} generate_worker_t;
+
+static
+generate_level_t*
+generate_level_make()
+{
+  generate_level_t *level =
+    (generate_level_t*) malloc(sizeof(generate_level_t));
+
+  assert(NULL != level);
+
+  level->size = 0;
+  level->capacity = 16;
+  level->entries = (generate_entry_t*) malloc(
+      level->capacity * sizeof(generate_entry_t));
+
+  assert(NULL != level->entries);
+
+  return level;
+}
+
+static
+void
+generate_level_free(
+    generate_level_t *level)
+{
+  free(level->entries);
+  free(level);
+}
+
+/* Copy of the path items of a level, to be referred to by the next one */
+static
+path_item_t*
+generate_level_paths(
+    generate_level_t const* level)
+{
+  path_item_t *items =
+    (path_item_t*) malloc(level->size * sizeof(path_item_t));
+
+  assert(NULL != items);
+
+  for (size_t i = 0; i < level->size; ++i)
+    items[i] = level->entries[i].item;
+
+  return items;
+}
+
+/* Generate a single list, without subtrees, recording its nodes */
+static
+void
+generate_level_add_list(
+    generate_level_t *level,
+    list_tree_arena_t *arena,
+    node_generator_t generator,
+    void *state,
+    path_item_t const* parent_path,
+    list_tree_node_t **slot)
+{
+  path_item_t item =
+  {
+    0,
+    parent_path
+  };
+
+  void *data;
+
+  while (generator(&item, state, &data))
+  {
+    list_tree_node_t *node = list_tree_arena_make(
+        arena,
+        data,
+        NULL,
+        NULL);
+
+    *slot = node;
+    slot = &node->next;
+
+    if (level->size == level->capacity)
+    {
+      level->capacity *= 2;
+      level->entries = (generate_entry_t*) realloc(
+          level->entries,
+          level->capacity * sizeof(generate_entry_t));
+
+      assert(NULL != level->entries);
+    }
+
+    level->entries[level->size].node = node;
+    level->entries[level->size].item = item;
+    ++ level->size;
+    ++ item.index;
+  }
+
+  *slot = NULL;
+}
+
+static
+void*
+generate_worker_run(
+    void *raw_worker)
+{
+  generate_worker_t *worker = (generate_worker_t*) raw_worker;
+  generate_pool_t *pool = worker->pool;
+  generate_level_t const* tasks = pool->tasks;
+
+  for (;;)
+  {
+    size_t i = __atomic_fetch_add(&pool->next_task, 1, __ATOMIC_RELAXED);
+
+    if (i >= tasks->size)
+      break;
+
+    generate_entry_t *entry = &tasks->entries[i];
+
+    list_tree_generate_list(
+        worker->arena,
+        pool->generator,
+        worker->state,
+        &entry->item,
+        &entry->node->first_child);
+  }
+
+  return NULL;
+}
+
+list_tree_node_t*
+list_tree_generate_parallel(
+    list_tree_arena_t *arena,
+    node_generator_t generator,
+    void *state,
+    generator_state_clone_t clone,
+    generator_state_release_t release,
+    size_t thread_count)
+{
+  assert(NULL != generator);
+
+  size_t worker_count = parallel_thread_count(thread_count);
+  size_t task_count = GENERATE_TASKS_PER_THREAD * worker_count;
+
+  list_tree_node_t *root;
+  generate_level_t *level = generate_level_make();
+  path_item_t *paths[GENERATE_MAX_DEPTH];
+  size_t depth = 0;
+
+  generate_level_add_list(level, arena, generator, state, NULL, &root);
+
+  /*
+    Narrow and deep trees cannot be split into enough tasks: the
+    expansion stops at a fixed depth, leaving whatever frontier
+    there is to the pool.
+  */
+  while (0 != level->size && level->size < task_count &&
+      depth < GENERATE_MAX_DEPTH)
+  {
+    generate_level_t *parents = level;
+    path_item_t *items = generate_level_paths(parents);
+
+    paths[depth ++] = items;
+    level = generate_level_make();
+
+    for (size_t i = 0; i < parents->size; ++i)
+    {
+      generate_level_add_list(
+          level,
+          arena,
+          generator,
+          state,
+          &items[i],
+          &parents->entries[i].node->first_child);
+    }
+
+    generate_level_free(parents);
+  }
+
+  generate_pool_t pool =
+  {
+    generator,
+    level,
+    0
+  };
+
+  generate_worker_t *workers = (generate_worker_t*) malloc(
+      worker_count * sizeof(generate_worker_t));
+  pthread_t *threads = (pthread_t*) malloc(
+      worker_count * sizeof(pthread_t));
+  int *is_started = (int*) malloc(worker_count * sizeof(int));
+
+  assert(NULL != workers);
+  assert(NULL != threads);
+  assert(NULL != is_started);
+
+  for (size_t i = 0; i < worker_count; ++i)
+  {
+    generate_worker_t *worker = &workers[i];
+
+    worker->pool = &pool;
+    worker->state = (0 == i || NULL == clone) ? state : clone(state);
+    worker->arena = (0 == i || NULL == arena)
+      ? arena
+      : list_tree_arena_create_inline(
+          0,
+          list_tree_arena_payload_size(arena));
+  }
+
+  /* Tasks left by a thread that failed to start are taken by the others */
+  for (size_t i = 1; i < worker_count; ++i)
+  {
+    is_started[i] = 0 == pthread_create(
+        &threads[i],
+        NULL,
+        generate_worker_run,
+        &workers[i]);
+  }
+
+  generate_worker_run(&workers[0]);
+
+  for (size_t i = 1; i < worker_count; ++i)
+  {
+    if (is_started[i])
+      pthread_join(threads[i], NULL);
+
+    if (NULL != clone && NULL != release)
+      release(workers[i].state);
+
+    if (NULL != arena)
+      list_tree_arena_merge(arena, workers[i].arena);
+  }
+
+  free(is_started);
+  free(threads);
+  free(workers);
+
+  generate_level_free(level);
+
+  while (0 != depth)
+    free(paths[-- depth]);
+
+  return root;
+}
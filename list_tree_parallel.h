@@ -0,0 +1,125 @@
+/*
+   Parallel traversal of list-trees.
+
+   A pool of threads walks the tree, each thread depth-first on
+   its own; a busy thread hands the shallowest of its pending
+   lists over to an idle one, which otherwise sleeps until there
+   is work or the traversal is over.  Nodes are visited in no
+   particular order, so the traversal suits analyses that do not
+   depend on it: counting, searching, collecting into per-thread
+   buffers and the like.
+
+   The tree must not be modified while the traversal is running.
+
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#ifndef _LIST_TREE_PARALLEL_H_
+#define _LIST_TREE_PARALLEL_H_
+
+#include "list_tree.h"
+#include "list_tree_arena.h"
+
+/*
+  Callback visiting a node.  Depth is 0 for the nodes of the root
+  list.  The return value tells how to proceed:
+  - positive: continue, including the children of the node;
+  - 0: skip the children of the node;
+  - negative: stop the whole traversal as soon as possible.
+*/
+typedef
+  int
+  (*list_tree_parallel_visitor_t)(
+      list_tree_node_t *node,
+      size_t depth,
+      void *worker_state);
+
+/* Callback to fold the state of a worker into the result */
+typedef
+  void
+  (*list_tree_state_merge_t)(
+      void *result,
+      void const* worker_state);
+
+/*
+  Visit each node of the tree by one of thread_count threads (0
+  means the number of online processors; the calling thread is
+  one of them).
+
+  Each thread has a private state of state_size bytes initialised
+  as a copy of initial_state, so the visitor needs no locking.
+  When all threads are finished, merge is called on the calling
+  thread once per worker to combine its state into result.
+*/
+void
+list_tree_traverse_parallel(
+    list_tree_node_t *root,
+    size_t thread_count,
+    list_tree_parallel_visitor_t visitor,
+    void const* initial_state,
+    size_t state_size,
+    list_tree_state_merge_t merge,
+    void *result);
+
+size_t
+list_tree_size_parallel(
+    list_tree_node_t *root,
+    size_t thread_count);
+
+/*
+  Return a node satisfying the predicate, or NULL.  If several
+  nodes match, any of them may be returned.  Once a match is
+  found, all threads stop.
+*/
+list_tree_node_t*
+list_tree_find_parallel(
+    list_tree_node_t *root,
+    predicate_t predicate,
+    void *predicate_param,
+    size_t thread_count);
+
+/* Callback to make a private copy of a generator state */
+typedef
+  void*
+  (*generator_state_clone_t)(
+      void const* state);
+
+/* Callback to free a copy made by generator_state_clone_t */
+typedef
+  void
+  (*generator_state_release_t)(
+      void *state);
+
+/*
+  Build the same tree as list_tree_arena_generate using
+  thread_count threads (0 means the number of online processors).
+  The calling thread generates the upper levels breadth-first
+  until there are enough independent child lists, or down to a
+  fixed depth for narrow trees, and the pool generates the lists
+  below them.
+
+  Thread-safety contract of the generator:
+  - it is called concurrently from several threads, and in no
+    particular order, so the data of a node must depend on its
+    path and on the state only;
+  - the calling thread uses state itself; every other thread uses
+    its own copy made by clone before the pool starts, and freed
+    by release (if not NULL) when it stops;
+  - if clone is NULL, all threads share state, which then must
+    be safe to use concurrently.
+
+  If the arena is not NULL, each thread allocates from its own
+  arena and all of them are merged into the given one at the end;
+  otherwise nodes come from the heap as usual.
+*/
+list_tree_node_t*
+list_tree_generate_parallel(
+    list_tree_arena_t *arena,
+    node_generator_t generator,
+    void *state,
+    generator_state_clone_t clone,
+    generator_state_release_t release,
+    size_t thread_count);
+
+#endif
@@ -0,0 +1,220 @@
+/*
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include "list_tree.h"
+#include "list_tree_node.h"
+#include "list_tree_persistent.h"
+
+/*
+  Make a node that takes over the references of the caller to its
+  next node and first child, and is referenced once itself.
+*/
+static
+list_tree_node_t*
+persistent_make(
+    void *data,
+    list_tree_node_t *next,
+    list_tree_node_t *first_child)
+{
+  list_tree_shared_t *shared = (list_tree_shared_t*) malloc(
+      sizeof(list_tree_shared_t) + sizeof(list_tree_node_t));
+
+  assert(NULL != shared);
+
+  list_tree_node_t *node = (list_tree_node_t*) (shared + 1);
+
+  node->data = data;
+  node->next = next;
+  node->first_child = first_child;
+  node->flags = NODE_SHARED;
+  shared->references = 1;
+
+  return node;
+}
+
+static
+void
+persistent_retain(
+    list_tree_node_t *node)
+{
+  if (NULL == node)
+    return;
+
+  assert(0 != (node->flags & NODE_SHARED));
+
+  __atomic_add_fetch(
+      &list_tree_shared_of(node)->references,
+      1,
+      __ATOMIC_RELAXED);
+}
+
+/*
+  Dropping the last reference to a node drops its references to
+  its next node and first child in turn; they are kept on a stack
+  rather than released recursively.
+*/
+void
+list_tree_snapshot_release(
+    list_tree_node_t *root)
+{
+  size_t capacity = 64;
+  size_t size = 0;
+  list_tree_node_t **stack = (list_tree_node_t**) malloc(
+      capacity * sizeof(list_tree_node_t*));
+
+  assert(NULL != stack);
+
+  stack[size ++] = root;
+
+  while (0 != size)
+  {
+    list_tree_node_t *node = stack[-- size];
+
+    if (NULL == node)
+      continue;
+
+    assert(0 != (node->flags & NODE_SHARED));
+
+    if (0 != __atomic_sub_fetch(
+        &list_tree_shared_of(node)->references,
+        1,
+        __ATOMIC_ACQ_REL))
+      continue;
+
+    if (size + 2 > capacity)
+    {
+      capacity *= 2;
+      stack = (list_tree_node_t**) realloc(
+          stack,
+          capacity * sizeof(list_tree_node_t*));
+
+      assert(NULL != stack);
+    }
+
+    stack[size ++] = node->next;
+    stack[size ++] = node->first_child;
+    list_tree_node_free(node);
+  }
+
+  free(stack);
+}
+
+list_tree_node_t*
+list_tree_snapshot(
+    list_tree_node_t *root)
+{
+  persistent_retain(root);
+
+  return root;
+}
+
+/*
+  Make the node at the link private to the tree the link belongs
+  to, copying it if anything else refers to it.  A single
+  reference can only be the link itself, and the count of a node
+  can only be raised through links the writer owns, so a node
+  seen referenced once is safe to change in place.
+*/
+static
+list_tree_node_t*
+persistent_own(
+    list_tree_node_t **link)
+{
+  list_tree_node_t *node = *link;
+
+  assert(NULL != node);
+
+  if (1 == __atomic_load_n(
+      &list_tree_shared_of(node)->references,
+      __ATOMIC_ACQUIRE))
+    return node;
+
+  persistent_retain(node->next);
+  persistent_retain(node->first_child);
+
+  *link = persistent_make(node->data, node->next, node->first_child);
+  list_tree_snapshot_release(node);
+
+  return *link;
+}
+
+/*
+  Own all nodes on the way to the path: the preceding siblings on
+  each level and the node itself.  Once a node is copied, the old
+  one keeps the nodes after it referenced, so they get copied as
+  well.  Returns the link to the node at the path.
+*/
+static
+list_tree_node_t**
+persistent_route(
+    list_tree_node_t **root,
+    size_t const* path,
+    size_t path_length)
+{
+  assert(NULL != root);
+  assert(0 != path_length);
+
+  list_tree_node_t **link = root;
+
+  for (size_t level = 0; ; ++level)
+  {
+    list_tree_node_t *node = persistent_own(link);
+
+    for (size_t i = path[level]; 0 != i; --i)
+    {
+      link = &node->next;
+      node = persistent_own(link);
+    }
+
+    if (level + 1 == path_length)
+      return link;
+
+    link = &node->first_child;
+  }
+}
+
+list_tree_node_t*
+list_tree_persistent_prepend_child(
+    list_tree_node_t **root,
+    size_t const* path,
+    size_t path_length,
+    void *data)
+{
+  list_tree_node_t **link = 0 == path_length
+    ? root
+    : &(*persistent_route(root, path, path_length))->first_child;
+
+  *link = persistent_make(data, *link, NULL);
+
+  return *link;
+}
+
+list_tree_node_t*
+list_tree_persistent_append(
+    list_tree_node_t **root,
+    size_t const* path,
+    size_t path_length,
+    void *data)
+{
+  list_tree_node_t *last = *persistent_route(root, path, path_length);
+
+  assert(NULL == last->next);
+
+  last->next = persistent_make(data, NULL, NULL);
+
+  return last->next;
+}
+
+void
+list_tree_persistent_set_data(
+    list_tree_node_t **root,
+    size_t const* path,
+    size_t path_length,
+    void *data)
+{
+  (*persistent_route(root, path, path_length))->data = data;
+}
@@ -0,0 +1,77 @@
+/*
+   Persistent list-trees with copy-on-write snapshots.
+
+   Nodes of a persistent tree count the references to them: links
+   from other nodes, the root held by the writer, and snapshots.
+   A snapshot is the root of the tree at some moment with one more
+   reference to it; taking it costs O(1).  Modifying the tree then
+   copies the nodes on the way to the change, i.e. the ancestors
+   of the changed node and their preceding siblings, as long as
+   they are still referenced by a snapshot; nodes referenced only
+   by the tree being modified are changed in place.  Other nodes
+   are shared, so memory grows with the changes made rather than
+   with the number of snapshots.
+
+   A snapshot never changes, so it can be read with any read-only
+   function of list_tree.h from any thread without locks.  The
+   tree is modified and snapshots are taken by a single writer at
+   a time; snapshots may be released by any thread.  Persistent
+   trees must never be passed to list_tree_dispose.
+
+   Data of nodes is shared between versions as is and is not
+   disposed by the library.
+
+   Nodes are addressed by paths as in list_tree_locate.
+
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#ifndef _LIST_TREE_PERSISTENT_H_
+#define _LIST_TREE_PERSISTENT_H_
+
+#include "list_tree.h"
+
+/*
+  Insert a node with the data as the first child of the node at
+  the path in the tree at *root, or as the first node of the root
+  list if path_length is 0.  Returns the new node.
+*/
+list_tree_node_t*
+list_tree_persistent_prepend_child(
+    list_tree_node_t **root,
+    size_t const* path,
+    size_t path_length,
+    void *data);
+
+/*
+  Insert a node with the data right after the node at the path,
+  which must exist and be the last of its list.  Returns the new
+  node.
+*/
+list_tree_node_t*
+list_tree_persistent_append(
+    list_tree_node_t **root,
+    size_t const* path,
+    size_t path_length,
+    void *data);
+
+/* Replace the data of the node at the path, which must exist */
+void
+list_tree_persistent_set_data(
+    list_tree_node_t **root,
+    size_t const* path,
+    size_t path_length,
+    void *data);
+
+/* Take a snapshot of the tree at the root */
+list_tree_node_t*
+list_tree_snapshot(
+    list_tree_node_t *root);
+
+/* Release a snapshot, or the tree itself, freeing unshared nodes */
+void
+list_tree_snapshot_release(
+    list_tree_node_t *root);
+
+#endif
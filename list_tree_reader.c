@@ -0,0 +1,338 @@
+/*
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "list_tree.h"
+#include "list_tree_reader.h"
+
+enum { READER_BLOCK_SIZE = 1 << 20 };
+
+typedef struct _reader_input_t
+{
+  FILE *file;
+  int fd;
+  char *buffer;
+  size_t capacity;
+  size_t start;
+  size_t end;
+  int is_eof;
+  int is_failed;
+} reader_input_t;
+
+typedef struct _reader_tag_t
+{
+  char const* text;
+  size_t length;
+} reader_tag_t;
+
+/*
+  Last node of each open list: tails[0] is in the root list,
+  tails[i + 1] in the children of tails[i].
+*/
+typedef struct _reader_levels_t
+{
+  list_tree_node_t **tails;
+  size_t size;
+  size_t capacity;
+} reader_levels_t;
+
+static
+void
+reader_fill(
+    reader_input_t *input)
+{
+  if (0 != input->start)
+  {
+    memmove(
+        input->buffer,
+        input->buffer + input->start,
+        input->end - input->start);
+    input->end -= input->start;
+    input->start = 0;
+  }
+
+  if (input->end == input->capacity)
+  {
+    input->capacity *= 2;
+    input->buffer = (char*) realloc(input->buffer, input->capacity);
+
+    assert(NULL != input->buffer);
+  }
+
+  size_t room = input->capacity - input->end;
+  char *place = input->buffer + input->end;
+
+  if (NULL != input->file)
+  {
+    size_t count = fread(place, 1, room, input->file);
+
+    input->end += count;
+    input->is_eof = 0 == count;
+    input->is_failed = input->is_eof && ferror(input->file);
+  }
+  else
+  {
+    ssize_t count;
+
+    do
+      count = read(input->fd, place, room);
+    while (0 > count && EINTR == errno);
+
+    input->end += 0 < count ? (size_t) count : 0;
+    input->is_eof = 0 >= count;
+    input->is_failed = 0 > count;
+  }
+}
+
+/* Get the next line without the newline; return 0 at the end */
+static
+int
+reader_next_line(
+    reader_input_t *input,
+    char const** line,
+    size_t *length)
+{
+  size_t scanned = input->start;
+
+  for (;;)
+  {
+    char *newline = (char*) memchr(
+        input->buffer + scanned,
+        '\n',
+        input->end - scanned);
+
+    if (NULL != newline)
+    {
+      *line = input->buffer + input->start;
+      *length = newline - *line;
+      input->start += *length + 1;
+      return 1;
+    }
+
+    if (input->is_eof)
+    {
+      *line = input->buffer + input->start;
+      *length = input->end - input->start;
+      input->start = input->end;
+      return 0 != *length;
+    }
+
+    scanned = input->end - input->start;
+    reader_fill(input);
+    scanned += input->start;
+  }
+}
+
+static
+reader_tag_t
+reader_make_tag(
+    char const* text)
+{
+  reader_tag_t tag = { text, 0 };
+
+  if (NULL != text)
+  {
+    tag.length = strlen(text);
+
+    if (0 != tag.length && '\n' == text[tag.length - 1])
+      -- tag.length;
+  }
+
+  return tag;
+}
+
+static
+int
+reader_is_tag(
+    reader_tag_t const* tag,
+    char const* line,
+    size_t length)
+{
+  return
+    NULL != tag->text &&
+    length == tag->length &&
+    0 == memcmp(line, tag->text, length);
+}
+
+static
+void
+reader_attach(
+    reader_levels_t *levels,
+    list_tree_node_t **root,
+    list_tree_node_t *node,
+    size_t level)
+{
+  assert(level <= levels->size);
+
+  if (level == levels->size)
+  {
+    if (levels->size == levels->capacity)
+    {
+      levels->capacity *= 2;
+      levels->tails = (list_tree_node_t**) realloc(
+          levels->tails,
+          levels->capacity * sizeof(list_tree_node_t*));
+
+      assert(NULL != levels->tails);
+    }
+
+    if (0 == level)
+      *root = node;
+    else
+      list_tree_prepend_child(levels->tails[level - 1], node);
+
+    ++ levels->size;
+  }
+  else
+  {
+    list_tree_append(levels->tails[level], node);
+    levels->size = level + 1;
+  }
+
+  levels->tails[level] = node;
+}
+
+static
+int
+reader_run(
+    reader_input_t *input,
+    list_tree_node_t **root,
+    data_reader_t reader,
+    char const* indent,
+    char const* opening_tag,
+    char const* closing_tag)
+{
+  assert(NULL != root);
+  assert(NULL != reader);
+
+  size_t indent_length = NULL == indent ? 0 : strlen(indent);
+  reader_tag_t opening = reader_make_tag(opening_tag);
+  reader_tag_t closing = reader_make_tag(closing_tag);
+
+  reader_levels_t levels;
+  levels.size = 0;
+  levels.capacity = 64;
+  levels.tails = (list_tree_node_t**) malloc(
+      levels.capacity * sizeof(list_tree_node_t*));
+
+  assert(NULL != levels.tails);
+
+  input->capacity = READER_BLOCK_SIZE;
+  input->buffer = (char*) malloc(input->capacity);
+  input->start = 0;
+  input->end = 0;
+  input->is_eof = 0;
+  input->is_failed = 0;
+
+  assert(NULL != input->buffer);
+
+  *root = NULL;
+
+  size_t tag_level = 0;
+  int is_ok = 1;
+  char const* line;
+  size_t length;
+
+  while (is_ok && reader_next_line(input, &line, &length))
+  {
+    if (reader_is_tag(&opening, line, length))
+    {
+      ++ tag_level;
+      continue;
+    }
+
+    if (reader_is_tag(&closing, line, length))
+    {
+      is_ok = 0 != tag_level;
+      -- tag_level;
+      continue;
+    }
+
+    size_t level = tag_level;
+
+    if (0 != indent_length)
+    {
+      level = 0;
+
+      while (length >= indent_length &&
+          0 == memcmp(line, indent, indent_length))
+      {
+        ++ level;
+        line += indent_length;
+        length -= indent_length;
+      }
+    }
+
+    void *data;
+
+    is_ok = level <= levels.size && reader(line, length, &data);
+
+    if (is_ok)
+    {
+      reader_attach(
+          &levels,
+          root,
+          list_tree_make_singleton(data),
+          level);
+    }
+  }
+
+  free(levels.tails);
+  free(input->buffer);
+
+  return is_ok && !input->is_failed;
+}
+
+int
+list_tree_read(
+    list_tree_node_t **root,
+    data_reader_t reader,
+    FILE *input,
+    char const* indent,
+    char const* opening_tag,
+    char const* closing_tag)
+{
+  assert(NULL != input);
+
+  reader_input_t source;
+  source.file = input;
+  source.fd = -1;
+
+  return reader_run(
+      &source,
+      root,
+      reader,
+      indent,
+      opening_tag,
+      closing_tag);
+}
+
+int
+list_tree_read_fd(
+    list_tree_node_t **root,
+    data_reader_t reader,
+    int fd,
+    char const* indent,
+    char const* opening_tag,
+    char const* closing_tag)
+{
+  reader_input_t source;
+  source.file = NULL;
+  source.fd = fd;
+
+  return reader_run(
+      &source,
+      root,
+      reader,
+      indent,
+      opening_tag,
+      closing_tag);
+}
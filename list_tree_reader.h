@@ -0,0 +1,62 @@
+/*
+   Reading list-trees back from the text written by list_tree_write.
+
+   The text is expected to have one line per node, i.e. the data
+   writer terminates its output with a newline, and each tag, if
+   given, is a line of its own, i.e. ends with a newline too.
+   The level of a node is the number of indents at the start of
+   its line; if indent is NULL, it is tracked by the opening and
+   closing tags instead.  Lines equal to a tag are never passed to
+   the data reader.
+
+   Input is read in large blocks in a single pass; only one block,
+   or one line if it is longer, is held in memory at a time.
+
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#ifndef _LIST_TREE_READER_H_
+#define _LIST_TREE_READER_H_
+
+#include <stdio.h>
+#include "list_tree.h"
+
+/*
+  Callback to make node data from a line of text, without the
+  indentation and the trailing newline.  Text is not terminated
+  by a zero byte.  Returns false (0) if the text is malformed.
+*/
+typedef
+  int
+  (*data_reader_t)(
+      char const* text,
+      size_t length,
+      void **data);
+
+/*
+  Read a tree to *root.  Return false (0) if the input cannot be
+  read, the data reader fails or the levels are inconsistent; in
+  that case *root holds the nodes read so far, to be disposed by
+  the caller.
+*/
+int
+list_tree_read(
+    list_tree_node_t **root,
+    data_reader_t reader,
+    FILE *input,
+    char const* indent,
+    char const* opening_tag,
+    char const* closing_tag);
+
+/* Same, reading directly from a file descriptor */
+int
+list_tree_read_fd(
+    list_tree_node_t **root,
+    data_reader_t reader,
+    int fd,
+    char const* indent,
+    char const* opening_tag,
+    char const* closing_tag);
+
+#endif
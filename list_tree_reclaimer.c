@@ -0,0 +1,260 @@
+/*
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "list_tree.h"
+#include "list_tree_node.h"
+#include "list_tree_reclaimer.h"
+
+typedef struct _reclaim_entry_t
+{
+  list_tree_node_t *root;
+  data_disposer_t disposer;
+  struct _reclaim_entry_t *next;
+} reclaim_entry_t;
+
+/*
+  Trees wait in a queue; the one being freed is taken out of it
+  into current.  Pending counts the trees not freed completely.
+  A background reclaimer whose thread could not be started has
+  no thread and frees trees as soon as they are handed over.
+*/
+struct _list_tree_reclaimer_t
+{
+  pthread_mutex_t lock;
+  pthread_cond_t has_work;
+  pthread_cond_t is_flushed;
+  reclaim_entry_t *first;
+  reclaim_entry_t *last;
+  reclaim_entry_t *current;
+  size_t pending;
+  int is_background;
+  int has_thread;
+  int is_stopping;
+  pthread_t thread;
+};
+
+/* Take the next tree to free; the lock is held */
+static
+reclaim_entry_t*
+reclaimer_pop(
+    list_tree_reclaimer_t *reclaimer)
+{
+  reclaim_entry_t *entry = reclaimer->first;
+
+  if (NULL != entry)
+  {
+    reclaimer->first = entry->next;
+
+    if (NULL == reclaimer->first)
+      reclaimer->last = NULL;
+  }
+
+  return entry;
+}
+
+/* Account for a freed tree; the lock is held */
+static
+void
+reclaimer_done(
+    list_tree_reclaimer_t *reclaimer,
+    reclaim_entry_t *entry)
+{
+  free(entry);
+
+  if (0 == -- reclaimer->pending)
+    pthread_cond_broadcast(&reclaimer->is_flushed);
+}
+
+static
+void*
+reclaimer_thread(
+    void *raw_reclaimer)
+{
+  list_tree_reclaimer_t *reclaimer = (list_tree_reclaimer_t*) raw_reclaimer;
+
+  pthread_mutex_lock(&reclaimer->lock);
+
+  while (1)
+  {
+    reclaim_entry_t *entry = reclaimer_pop(reclaimer);
+
+    if (NULL == entry)
+    {
+      if (reclaimer->is_stopping)
+        break;
+
+      pthread_cond_wait(&reclaimer->has_work, &reclaimer->lock);
+      continue;
+    }
+
+    pthread_mutex_unlock(&reclaimer->lock);
+    list_tree_free_nodes(&entry->root, entry->disposer, SIZE_MAX);
+    pthread_mutex_lock(&reclaimer->lock);
+
+    reclaimer_done(reclaimer, entry);
+  }
+
+  pthread_mutex_unlock(&reclaimer->lock);
+
+  return NULL;
+}
+
+list_tree_reclaimer_t*
+list_tree_reclaimer_create(
+    int is_background)
+{
+  list_tree_reclaimer_t *reclaimer =
+    (list_tree_reclaimer_t*) malloc(sizeof(list_tree_reclaimer_t));
+
+  assert(NULL != reclaimer);
+
+  pthread_mutex_init(&reclaimer->lock, NULL);
+  pthread_cond_init(&reclaimer->has_work, NULL);
+  pthread_cond_init(&reclaimer->is_flushed, NULL);
+  reclaimer->first = NULL;
+  reclaimer->last = NULL;
+  reclaimer->current = NULL;
+  reclaimer->pending = 0;
+  reclaimer->is_background = is_background;
+  reclaimer->is_stopping = 0;
+  reclaimer->has_thread = is_background && 0 == pthread_create(
+      &reclaimer->thread,
+      NULL,
+      reclaimer_thread,
+      reclaimer);
+
+  return reclaimer;
+}
+
+void
+list_tree_reclaimer_dispose(
+    list_tree_reclaimer_t *reclaimer)
+{
+  assert(NULL != reclaimer);
+
+  list_tree_reclaimer_flush(reclaimer);
+
+  if (reclaimer->has_thread)
+  {
+    pthread_mutex_lock(&reclaimer->lock);
+    reclaimer->is_stopping = 1;
+    pthread_cond_signal(&reclaimer->has_work);
+    pthread_mutex_unlock(&reclaimer->lock);
+
+    pthread_join(reclaimer->thread, NULL);
+  }
+
+  pthread_cond_destroy(&reclaimer->is_flushed);
+  pthread_cond_destroy(&reclaimer->has_work);
+  pthread_mutex_destroy(&reclaimer->lock);
+  free(reclaimer);
+}
+
+void
+list_tree_dispose_async(
+    list_tree_reclaimer_t *reclaimer,
+    list_tree_node_t *root,
+    data_disposer_t data_disposer)
+{
+  assert(NULL != reclaimer);
+
+  if (NULL == root)
+    return;
+
+  if (reclaimer->is_background && !reclaimer->has_thread)
+  {
+    list_tree_free_nodes(&root, data_disposer, SIZE_MAX);
+    return;
+  }
+
+  reclaim_entry_t *entry = (reclaim_entry_t*) malloc(sizeof(reclaim_entry_t));
+
+  assert(NULL != entry);
+
+  entry->root = root;
+  entry->disposer = data_disposer;
+  entry->next = NULL;
+
+  pthread_mutex_lock(&reclaimer->lock);
+
+  if (NULL == reclaimer->last)
+    reclaimer->first = entry;
+  else
+    reclaimer->last->next = entry;
+
+  reclaimer->last = entry;
+  ++ reclaimer->pending;
+  pthread_cond_signal(&reclaimer->has_work);
+  pthread_mutex_unlock(&reclaimer->lock);
+}
+
+/*
+  Steps are run by one thread at a time, which owns the current
+  tree; the lock only guards the queue and the counter.
+*/
+size_t
+list_tree_dispose_step(
+    list_tree_reclaimer_t *reclaimer,
+    size_t budget)
+{
+  assert(NULL != reclaimer);
+  assert(!reclaimer->is_background);
+
+  size_t count = 0;
+
+  while (count < budget)
+  {
+    if (NULL == reclaimer->current)
+    {
+      pthread_mutex_lock(&reclaimer->lock);
+      reclaimer->current = reclaimer_pop(reclaimer);
+      pthread_mutex_unlock(&reclaimer->lock);
+
+      if (NULL == reclaimer->current)
+        break;
+    }
+
+    reclaim_entry_t *entry = reclaimer->current;
+
+    count += list_tree_free_nodes(&entry->root, entry->disposer, budget - count);
+
+    if (NULL == entry->root)
+    {
+      reclaimer->current = NULL;
+
+      pthread_mutex_lock(&reclaimer->lock);
+      reclaimer_done(reclaimer, entry);
+      pthread_mutex_unlock(&reclaimer->lock);
+    }
+  }
+
+  return count;
+}
+
+void
+list_tree_reclaimer_flush(
+    list_tree_reclaimer_t *reclaimer)
+{
+  assert(NULL != reclaimer);
+
+  if (!reclaimer->is_background)
+  {
+    list_tree_dispose_step(reclaimer, SIZE_MAX);
+    return;
+  }
+
+  pthread_mutex_lock(&reclaimer->lock);
+
+  while (0 != reclaimer->pending)
+    pthread_cond_wait(&reclaimer->is_flushed, &reclaimer->lock);
+
+  pthread_mutex_unlock(&reclaimer->lock);
+}
@@ -0,0 +1,73 @@
+/*
+   Deferred disposal of list-trees.
+
+   A reclaimer takes trees to dispose in O(1) and frees them later:
+   either on a background thread of its own, or in steps of bounded
+   work run by the application, e.g. from an idle handler of an
+   event loop.  Either way, disposal needs no memory beyond the
+   nodes themselves, whatever the shape of the trees, so it cannot
+   fail or grow the stack on huge trees.
+
+   Nodes are freed in no particular order; the data of each node is
+   passed to the data disposer given with its tree, except for the
+   payloads of inline nodes.  Trees handed to a reclaimer belong to
+   it and must not be accessed any more.  Like with
+   list_tree_dispose, nodes of arenas and persistent trees must not
+   be handed to a reclaimer.
+
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#ifndef _LIST_TREE_RECLAIMER_H_
+#define _LIST_TREE_RECLAIMER_H_
+
+#include "list_tree.h"
+
+typedef
+  struct _list_tree_reclaimer_t
+  list_tree_reclaimer_t;
+
+/*
+  Create a reclaimer freeing trees on a background thread if
+  is_background is true, or only in list_tree_dispose_step.  If
+  the thread cannot be started, list_tree_dispose_async frees the
+  trees itself before returning.
+*/
+list_tree_reclaimer_t*
+list_tree_reclaimer_create(
+    int is_background);
+
+/* Flush the reclaimer, stop its thread if any, and free it */
+void
+list_tree_reclaimer_dispose(
+    list_tree_reclaimer_t *reclaimer);
+
+/*
+  Hand a tree over to the reclaimer.  Safe to call from several
+  threads at once.
+*/
+void
+list_tree_dispose_async(
+    list_tree_reclaimer_t *reclaimer,
+    list_tree_node_t *root,
+    data_disposer_t data_disposer);
+
+/*
+  Free the trees handed over to a reclaimer without a background
+  thread, in at most budget units of work.  A unit either frees a
+  node or moves one up out of the way, so a tree of n nodes takes
+  less than 2n units.  Returns the number of units done, which is
+  less than the budget only when nothing is left.
+*/
+size_t
+list_tree_dispose_step(
+    list_tree_reclaimer_t *reclaimer,
+    size_t budget);
+
+/* Wait until all trees handed over so far have been freed */
+void
+list_tree_reclaimer_flush(
+    list_tree_reclaimer_t *reclaimer);
+
+#endif
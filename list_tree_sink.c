@@ -0,0 +1,416 @@
+/*
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "list_tree.h"
+#include "list_tree_sink.h"
+
+enum { SINK_DEFAULT_CAPACITY = 1 << 16 };
+
+typedef enum _sink_kind_t
+{
+  SINK_FD,
+  SINK_CALLBACK,
+  SINK_MEMORY
+} sink_kind_t;
+
+struct _list_tree_sink_t
+{
+  sink_kind_t kind;
+  int fd;
+  sink_flusher_t flusher;
+  void *context;
+  char *buffer;
+  size_t size;
+  size_t capacity;
+  int is_owning;
+  int is_failed;
+};
+
+static
+list_tree_sink_t*
+sink_make(
+    sink_kind_t kind,
+    char *buffer,
+    size_t capacity)
+{
+  list_tree_sink_t *sink =
+    (list_tree_sink_t*) calloc(1, sizeof(list_tree_sink_t));
+
+  assert(NULL != sink);
+
+  sink->kind = kind;
+  sink->fd = -1;
+  sink->capacity = 0 == capacity ? SINK_DEFAULT_CAPACITY : capacity;
+  sink->is_owning = NULL == buffer;
+  sink->buffer = sink->is_owning ? (char*) malloc(sink->capacity) : buffer;
+
+  assert(NULL != sink->buffer);
+
+  return sink;
+}
+
+list_tree_sink_t*
+list_tree_sink_create_fd(
+    int fd,
+    char *buffer,
+    size_t capacity)
+{
+  list_tree_sink_t *sink = sink_make(SINK_FD, buffer, capacity);
+
+  sink->fd = fd;
+
+  return sink;
+}
+
+list_tree_sink_t*
+list_tree_sink_create(
+    sink_flusher_t flusher,
+    void *context,
+    char *buffer,
+    size_t capacity)
+{
+  assert(NULL != flusher);
+
+  list_tree_sink_t *sink = sink_make(SINK_CALLBACK, buffer, capacity);
+
+  sink->flusher = flusher;
+  sink->context = context;
+
+  return sink;
+}
+
+list_tree_sink_t*
+list_tree_sink_create_memory(
+    size_t initial_capacity)
+{
+  return sink_make(SINK_MEMORY, NULL, initial_capacity);
+}
+
+/* Write all the pieces to the descriptor, retrying short writes */
+static
+int
+sink_write_fd(
+    int fd,
+    struct iovec *pieces,
+    int count)
+{
+  while (0 != count)
+  {
+    ssize_t written = writev(fd, pieces, count);
+
+    if (0 > written)
+    {
+      if (EINTR == errno)
+        continue;
+
+      return 0;
+    }
+
+    while (0 != count && (size_t) written >= pieces->iov_len)
+    {
+      written -= pieces->iov_len;
+      ++ pieces;
+      -- count;
+    }
+
+    if (0 != count)
+    {
+      pieces->iov_base = (char*) pieces->iov_base + written;
+      pieces->iov_len -= written;
+    }
+  }
+
+  return 1;
+}
+
+/*
+  Pass on the buffer followed by extra bytes, if any, in one go:
+  a single writev for a descriptor.
+*/
+static
+int
+sink_drain(
+    list_tree_sink_t *sink,
+    void const* extra,
+    size_t extra_size)
+{
+  int is_ok = 1;
+
+  switch (sink->kind)
+  {
+    case SINK_FD:
+    {
+      struct iovec pieces[2] =
+      {
+        { sink->buffer, sink->size },
+        { (void*) extra, extra_size }
+      };
+
+      is_ok = sink_write_fd(sink->fd, pieces, 0 == extra_size ? 1 : 2);
+      break;
+    }
+
+    case SINK_CALLBACK:
+      is_ok =
+        (0 == sink->size ||
+          sink->flusher(sink->context, sink->buffer, sink->size)) &&
+        (0 == extra_size ||
+          sink->flusher(sink->context, (char const*) extra, extra_size));
+      break;
+
+    case SINK_MEMORY:
+      assert(0 == extra_size);
+      return 1;
+  }
+
+  sink->size = 0;
+
+  if (!is_ok)
+    sink->is_failed = 1;
+
+  return is_ok;
+}
+
+int
+list_tree_sink_put(
+    list_tree_sink_t *sink,
+    void const* bytes,
+    size_t size)
+{
+  assert(NULL != sink);
+
+  if (sink->size + size <= sink->capacity)
+  {
+    memcpy(sink->buffer + sink->size, bytes, size);
+    sink->size += size;
+    return 1;
+  }
+
+  if (SINK_MEMORY == sink->kind)
+  {
+    while (sink->size + size > sink->capacity)
+      sink->capacity *= 2;
+
+    sink->buffer = (char*) realloc(sink->buffer, sink->capacity);
+
+    assert(NULL != sink->buffer);
+
+    memcpy(sink->buffer + sink->size, bytes, size);
+    sink->size += size;
+    return 1;
+  }
+
+  if (size < sink->capacity)
+  {
+    int is_ok = sink_drain(sink, NULL, 0);
+
+    memcpy(sink->buffer, bytes, size);
+    sink->size = size;
+    return is_ok;
+  }
+
+  return sink_drain(sink, bytes, size);
+}
+
+int
+list_tree_sink_puts(
+    list_tree_sink_t *sink,
+    char const* text)
+{
+  return list_tree_sink_put(sink, text, strlen(text));
+}
+
+int
+list_tree_sink_flush(
+    list_tree_sink_t *sink)
+{
+  assert(NULL != sink);
+
+  return sink_drain(sink, NULL, 0);
+}
+
+char const*
+list_tree_sink_memory(
+    list_tree_sink_t const* sink,
+    size_t *size)
+{
+  assert(NULL != sink);
+  assert(SINK_MEMORY == sink->kind);
+
+  if (NULL != size)
+    *size = sink->size;
+
+  return sink->buffer;
+}
+
+int
+list_tree_sink_dispose(
+    list_tree_sink_t *sink)
+{
+  assert(NULL != sink);
+
+  list_tree_sink_flush(sink);
+
+  int is_ok = !sink->is_failed;
+
+  if (sink->is_owning)
+    free(sink->buffer);
+
+  free(sink);
+
+  return is_ok;
+}
+
+/*
+  Indents holds the indent repeated for the deepest level seen so
+  far; a prefix of it is the indentation of any other level.
+*/
+typedef struct _sink_write_state_t
+{
+  size_t level;
+  data_sink_writer_t writer;
+  list_tree_sink_t *sink;
+  char const* indent;
+  size_t indent_length;
+  char *indents;
+  size_t indents_level;
+  char const* opening_tag;
+  char const* closing_tag;
+  int is_ok;
+} sink_write_state_t;
+
+static
+char const*
+sink_indentation(
+    sink_write_state_t *state,
+    size_t level)
+{
+  if (level > state->indents_level)
+  {
+    size_t indents_level = 2 * state->indents_level;
+
+    if (indents_level < level)
+      indents_level = level;
+
+    state->indents = (char*) realloc(
+        state->indents,
+        indents_level * state->indent_length);
+
+    assert(NULL != state->indents);
+
+    for (size_t i = state->indents_level; i < indents_level; ++i)
+    {
+      memcpy(
+          state->indents + i * state->indent_length,
+          state->indent,
+          state->indent_length);
+    }
+
+    state->indents_level = indents_level;
+  }
+
+  return state->indents;
+}
+
+static
+int
+sink_write_pre_visitor(
+    list_tree_node_t *node,
+    void *raw_state)
+{
+  sink_write_state_t *state = (sink_write_state_t*) raw_state;
+
+  if (0 != state->indent_length && 0 != state->level)
+  {
+    state->is_ok = state->is_ok && 0 != list_tree_sink_put(
+        state->sink,
+        sink_indentation(state, state->level),
+        state->level * state->indent_length);
+  }
+
+  state->is_ok = state->is_ok && 0 != state->writer(
+      state->sink,
+      list_tree_get_data(node));
+
+  return 1;
+}
+
+static
+int
+sink_write_descent(
+    void *raw_state)
+{
+  sink_write_state_t *state = (sink_write_state_t*) raw_state;
+
+  if (NULL != state->opening_tag)
+    state->is_ok =
+      state->is_ok && 0 != list_tree_sink_puts(state->sink, state->opening_tag);
+
+  ++ state->level;
+  return 1;
+}
+
+static
+void
+sink_write_ascent(
+    void *raw_state)
+{
+  sink_write_state_t *state = (sink_write_state_t*) raw_state;
+
+  if (NULL != state->closing_tag)
+    state->is_ok =
+      state->is_ok && 0 != list_tree_sink_puts(state->sink, state->closing_tag);
+
+  -- state->level;
+}
+
+int
+list_tree_write_sink(
+    list_tree_node_t *root,
+    data_sink_writer_t writer,
+    list_tree_sink_t *sink,
+    char const* indent,
+    char const* opening_tag,
+    char const* closing_tag)
+{
+  assert(NULL != writer);
+  assert(NULL != sink);
+
+  sink_write_state_t state =
+  {
+    0,
+    writer,
+    sink,
+    indent,
+    NULL == indent ? 0 : strlen(indent),
+    NULL,
+    0,
+    opening_tag,
+    closing_tag,
+    1
+  };
+
+  list_tree_traverse_depth(
+      root,
+      sink_write_pre_visitor,
+      sink_write_descent,
+      sink_write_ascent,
+      NULL,
+      NULL,
+      NULL,
+      &state);
+
+  free(state.indents);
+
+  return state.is_ok;
+}
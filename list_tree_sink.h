@@ -0,0 +1,106 @@
+/*
+   Buffered output sinks for writing list-trees.
+
+   A sink collects output in a buffer and passes it on in large
+   chunks: to a file descriptor with write/writev, to a growing
+   memory block, or to a user-supplied callback.  Unlike stdio,
+   a sink takes no locks.
+
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#ifndef _LIST_TREE_SINK_H_
+#define _LIST_TREE_SINK_H_
+
+#include "list_tree.h"
+
+typedef
+  struct _list_tree_sink_t
+  list_tree_sink_t;
+
+/* Callback to pass buffered output on; returns false (0) on error */
+typedef
+  int
+  (*sink_flusher_t)(
+      void *context,
+      char const* bytes,
+      size_t size);
+
+/*
+  Callback to write node data to a sink; returns true (non-0) on
+  success and false (0) on error, like list_tree_sink_put.
+*/
+typedef
+  int
+  (*data_sink_writer_t)(
+      list_tree_sink_t *sink,
+      void *data);
+
+/*
+  Constructors.  If buffer is NULL, a buffer of the given
+  capacity is allocated (0 selects a default); otherwise the
+  caller's buffer is used and must outlive the sink.
+*/
+list_tree_sink_t*
+list_tree_sink_create_fd(
+    int fd,
+    char *buffer,
+    size_t capacity);
+
+list_tree_sink_t*
+list_tree_sink_create(
+    sink_flusher_t flusher,
+    void *context,
+    char *buffer,
+    size_t capacity);
+
+/* A sink accumulating all output in memory */
+list_tree_sink_t*
+list_tree_sink_create_memory(
+    size_t initial_capacity);
+
+/*
+  Flush and free the sink.  Return false (0) if any output error
+  has occurred during its lifetime.
+*/
+int
+list_tree_sink_dispose(
+    list_tree_sink_t *sink);
+
+int
+list_tree_sink_put(
+    list_tree_sink_t *sink,
+    void const* bytes,
+    size_t size);
+
+int
+list_tree_sink_puts(
+    list_tree_sink_t *sink,
+    char const* text);
+
+int
+list_tree_sink_flush(
+    list_tree_sink_t *sink);
+
+/* Output accumulated by a memory sink so far */
+char const*
+list_tree_sink_memory(
+    list_tree_sink_t const* sink,
+    size_t *size);
+
+/*
+  Same as list_tree_write, but writing to a sink.  Indentation of
+  each level is prepared once and written with a single put.
+  Return false (0) on an output error.
+*/
+int
+list_tree_write_sink(
+    list_tree_node_t *root,
+    data_sink_writer_t writer,
+    list_tree_sink_t *sink,
+    char const* indent,
+    char const* opening_tag,
+    char const* closing_tag);
+
+#endif
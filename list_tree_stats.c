@@ -0,0 +1,292 @@
+/*
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "list_tree.h"
+#include "list_tree_node.h"
+#include "list_tree_parallel.h"
+#include "list_tree_stats.h"
+
+/* Statistics being gathered, with the room for levels */
+typedef struct _stats_builder_t
+{
+  list_tree_stats_t stats;
+  size_t capacity;
+} stats_builder_t;
+
+static
+size_t
+fan_out_bucket(
+    size_t fan_out)
+{
+  size_t bucket = 0;
+
+  while (0 != fan_out)
+  {
+    fan_out >>= 1;
+    ++ bucket;
+  }
+
+  return bucket;
+}
+
+static
+size_t
+node_footprint(
+    list_tree_node_t const* node)
+{
+  size_t footprint = sizeof(list_tree_node_t);
+
+  if (0 != (node->flags & NODE_AUGMENTED))
+  {
+    footprint += sizeof(list_tree_augment_t);
+
+    if (list_tree_augment_of(node)->list->first == node)
+      footprint += sizeof(list_tree_augment_list_t);
+  }
+
+  if (0 != (node->flags & NODE_LAZY))
+    footprint += sizeof(list_tree_lazy_t);
+
+  if (0 != (node->flags & NODE_SHARED))
+    footprint += sizeof(list_tree_shared_t);
+
+  return footprint;
+}
+
+/* Count a node on the level, adding levels down to it if needed */
+static
+void
+stats_count_node(
+    stats_builder_t *builder,
+    list_tree_node_t const* node,
+    size_t depth)
+{
+  list_tree_stats_t *stats = &builder->stats;
+
+  while (depth >= stats->depth)
+  {
+    if (stats->depth == builder->capacity)
+    {
+      builder->capacity = 0 == builder->capacity ? 16 : 2 * builder->capacity;
+      stats->level_sizes = (size_t*) realloc(
+          stats->level_sizes,
+          builder->capacity * sizeof(size_t));
+
+      assert(NULL != stats->level_sizes);
+    }
+
+    stats->level_sizes[stats->depth ++] = 0;
+  }
+
+  ++ stats->size;
+  ++ stats->level_sizes[depth];
+  stats->memory += node_footprint(node);
+}
+
+static
+void
+stats_count_list(
+    list_tree_stats_t *stats,
+    size_t length)
+{
+  ++ stats->fan_out[fan_out_bucket(length)];
+
+  if (stats->longest_run < length)
+    stats->longest_run = length;
+}
+
+typedef struct _stats_frame_t
+{
+  list_tree_node_t *node;
+  size_t run;
+} stats_frame_t;
+
+/*
+  Each frame walks a list, counting its nodes; when the list ends,
+  its length is the fan-out of the parent.  Leaves are counted
+  when they turn out to have no children.
+*/
+void
+list_tree_stats(
+    list_tree_node_t *root,
+    list_tree_stats_t *stats)
+{
+  assert(NULL != stats);
+
+  stats_builder_t builder;
+  memset(&builder, 0, sizeof(builder));
+
+  size_t capacity = 64;
+  size_t size = 0;
+  stats_frame_t *frames = (stats_frame_t*) malloc(
+      capacity * sizeof(stats_frame_t));
+
+  assert(NULL != frames);
+
+  frames[size].node = root;
+  frames[size ++].run = 0;
+
+  while (0 != size)
+  {
+    stats_frame_t *frame = &frames[size - 1];
+    list_tree_node_t *node = frame->node;
+
+    if (NULL == node)
+    {
+      if (1 == size)
+      {
+        builder.stats.length = frame->run;
+
+        if (builder.stats.longest_run < frame->run)
+          builder.stats.longest_run = frame->run;
+      }
+      else
+      {
+        stats_count_list(&builder.stats, frame->run);
+      }
+
+      -- size;
+      continue;
+    }
+
+    stats_count_node(&builder, node, size - 1);
+    ++ frame->run;
+    frame->node = list_tree_node_next(node);
+
+    list_tree_node_t *first_child = list_tree_node_first_child(node);
+
+    if (NULL == first_child)
+    {
+      ++ builder.stats.fan_out[0];
+      continue;
+    }
+
+    if (size == capacity)
+    {
+      capacity *= 2;
+      frames = (stats_frame_t*) realloc(
+          frames,
+          capacity * sizeof(stats_frame_t));
+
+      assert(NULL != frames);
+    }
+
+    frames[size].node = first_child;
+    frames[size ++].run = 0;
+  }
+
+  free(frames);
+
+  *stats = builder.stats;
+}
+
+static
+int
+parallel_stats_visitor(
+    list_tree_node_t *node,
+    size_t depth,
+    void *raw_builder)
+{
+  stats_builder_t *builder = (stats_builder_t*) raw_builder;
+  size_t fan_out = 0;
+
+  stats_count_node(builder, node, depth);
+
+  for (list_tree_node_t *child = list_tree_node_first_child(node);
+      NULL != child;
+      child = list_tree_node_next(child))
+    ++ fan_out;
+
+  stats_count_list(&builder->stats, fan_out);
+
+  return 1;
+}
+
+static
+void
+parallel_stats_merge(
+    void *raw_result,
+    void const* raw_builder)
+{
+  list_tree_stats_t *result = &((stats_builder_t*) raw_result)->stats;
+  list_tree_stats_t const* stats = &((stats_builder_t const*) raw_builder)->stats;
+
+  if (result->depth < stats->depth)
+  {
+    result->level_sizes = (size_t*) realloc(
+        result->level_sizes,
+        stats->depth * sizeof(size_t));
+
+    assert(NULL != result->level_sizes);
+
+    for (size_t i = result->depth; i < stats->depth; ++i)
+      result->level_sizes[i] = 0;
+
+    result->depth = stats->depth;
+  }
+
+  for (size_t i = 0; i < stats->depth; ++i)
+    result->level_sizes[i] += stats->level_sizes[i];
+
+  for (size_t i = 0; i < LIST_TREE_FAN_OUT_BUCKETS; ++i)
+    result->fan_out[i] += stats->fan_out[i];
+
+  result->size += stats->size;
+  result->memory += stats->memory;
+
+  if (result->longest_run < stats->longest_run)
+    result->longest_run = stats->longest_run;
+
+  free(stats->level_sizes);
+}
+
+/*
+  Each worker gathers its own statistics, counting the children
+  of every node it visits; the length of the root list, which has
+  no parent, is counted separately.
+*/
+void
+list_tree_stats_parallel(
+    list_tree_node_t *root,
+    size_t thread_count,
+    list_tree_stats_t *stats)
+{
+  assert(NULL != stats);
+
+  stats_builder_t initial;
+  stats_builder_t result;
+
+  memset(&initial, 0, sizeof(initial));
+  memset(&result, 0, sizeof(result));
+
+  list_tree_traverse_parallel(
+      root,
+      thread_count,
+      parallel_stats_visitor,
+      &initial,
+      sizeof(stats_builder_t),
+      parallel_stats_merge,
+      &result);
+
+  result.stats.length = list_tree_length(root);
+
+  if (result.stats.longest_run < result.stats.length)
+    result.stats.longest_run = result.stats.length;
+
+  *stats = result.stats;
+}
+
+void
+list_tree_stats_dispose(
+    list_tree_stats_t *stats)
+{
+  assert(NULL != stats);
+
+  free(stats->level_sizes);
+  stats->level_sizes = NULL;
+}
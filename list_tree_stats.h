@@ -0,0 +1,60 @@
+/*
+   Shape statistics of list-trees gathered in a single pass.
+
+   Size, length and depth are the same as given by list_tree_size,
+   list_tree_length and list_tree_depth, but computed together with
+   the rest, so that a memory-bound tree is read once instead of
+   once per figure.
+
+   Vadim Vinnik, 2015, just for fun
+   vadim.vinnik@gmail.com
+*/
+
+#ifndef _LIST_TREE_STATS_H_
+#define _LIST_TREE_STATS_H_
+
+#include <limits.h>
+#include "list_tree.h"
+
+/* Bucket 0 counts leaves, bucket k nodes with 2^(k-1) to 2^k - 1 children */
+enum { LIST_TREE_FAN_OUT_BUCKETS = sizeof(size_t) * CHAR_BIT + 1 };
+
+typedef struct _list_tree_stats_t
+{
+  size_t size;
+  size_t length;
+  size_t depth;
+  /* Number of nodes on each of the depth levels, root list first */
+  size_t *level_sizes;
+  size_t fan_out[LIST_TREE_FAN_OUT_BUCKETS];
+  /* Number of nodes in the longest list */
+  size_t longest_run;
+  /*
+    Bytes taken by the nodes together with the metadata of their
+    variants; payloads of inline nodes, data and allocator overhead
+    are not counted.
+  */
+  size_t memory;
+} list_tree_stats_t;
+
+void
+list_tree_stats(
+    list_tree_node_t *root,
+    list_tree_stats_t *stats);
+
+/*
+  Same using thread_count threads, see list_tree_traverse_parallel.
+  Each node is read once more to count the children of its parent.
+*/
+void
+list_tree_stats_parallel(
+    list_tree_node_t *root,
+    size_t thread_count,
+    list_tree_stats_t *stats);
+
+/* Free the memory held by the statistics */
+void
+list_tree_stats_dispose(
+    list_tree_stats_t *stats);
+
+#endif
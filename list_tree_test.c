@@ -3,15 +3,37 @@
    vadim.vinnik@gmail.com
 */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
 #include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 #include <malloc.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "list_tree.h"
+#include "list_tree_arena.h"
+#include "list_tree_binary.h"
+#include "list_tree_builder.h"
+#include "list_tree_cursor.h"
+#include "list_tree_frozen.h"
+#include "list_tree_hash.h"
+#include "list_tree_lazy.h"
+#include "list_tree_locator.h"
+#include "list_tree_parallel.h"
+#include "list_tree_persistent.h"
+#include "list_tree_reader.h"
+#include "list_tree_reclaimer.h"
+#include "list_tree_sink.h"
+#include "list_tree_stats.h"
 #include "list_tree_test_data_creator.h"
 
 static int const test_tree_length = 3;
 static int const test_tree_depth = 4;
+static size_t const test_long_list_length = 1000000;
 
 static
 list_tree_node_t*
@@ -61,21 +83,34 @@ test_print()
   list_tree_dispose(tree, NULL);
 }
 
+/* Free bytes in the heap; mallinfo is deprecated since glibc 2.33 */
+static
+size_t
+heap_free_size()
+{
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  return mallinfo2().fordblks;
+#else
+  return (size_t) mallinfo().fordblks;
+#endif
+}
+
 static
 void
 test_memory()
 {
-  int free_before_create = mallinfo().fordblks;
+  size_t free_before_create = heap_free_size();
 
   list_tree_node_t *tree = make_test_object();
 
-  int free_after_create = mallinfo().fordblks;
+  size_t free_after_create = heap_free_size();
 
   assert(free_after_create < free_before_create);
 
   list_tree_dispose(tree, NULL);
 
-  int free_after_dispose = mallinfo().fordblks;
+  size_t free_after_dispose = heap_free_size();
 
   assert(free_before_create == free_after_dispose);
 }
@@ -173,6 +208,2264 @@ test_locate()
   list_tree_dispose(tree, NULL);
 }
 
+static
+list_tree_node_t*
+make_long_list(
+    size_t length)
+{
+  list_tree_node_t *list = NULL;
+
+  for (size_t i = length; i != 0; --i)
+    list = list_tree_make((void*) (long) (i - 1), list, NULL);
+
+  return list;
+}
+
+static
+list_tree_node_t*
+make_long_chain(
+    size_t length)
+{
+  list_tree_node_t *chain = NULL;
+
+  for (size_t i = length; i != 0; --i)
+    chain = list_tree_make((void*) (long) (i - 1), NULL, chain);
+
+  return chain;
+}
+
+static
+void
+test_long_list()
+{
+  list_tree_node_t *list = make_long_list(test_long_list_length);
+
+  assert(list_tree_size(list) == test_long_list_length);
+  assert(list_tree_length(list) == test_long_list_length);
+  assert(list_tree_depth(list) == 1);
+
+  int last_key = (int) test_long_list_length - 1;
+  list_tree_node_t *last = find_wrapped_int(list, last_key);
+
+  assert(NULL != last);
+  assert(NULL == list_tree_get_next(last));
+
+  size_t path[] = { test_long_list_length - 1 };
+  assert(last == list_tree_locate(list, path, 1));
+
+  list_tree_dispose(list, NULL);
+
+  list_tree_node_t *chain = make_long_chain(test_long_list_length);
+
+  assert(list_tree_size(chain) == test_long_list_length);
+  assert(list_tree_length(chain) == 1);
+  assert(list_tree_depth(chain) == test_long_list_length);
+  assert(NULL != find_wrapped_int(chain, last_key));
+
+  list_tree_dispose(chain, NULL);
+}
+
+static size_t disposed_count = 0;
+
+static
+void
+counting_disposer(
+    void *_)
+{
+  ++ disposed_count;
+}
+
+static
+void
+test_arena()
+{
+  list_tree_arena_t *arena = list_tree_arena_create(7);
+
+  list_tree_node_t *tree = make_wrapped_int_tree_in_arena(
+      arena,
+      test_tree_length,
+      test_tree_depth);
+
+  size_t size = list_tree_size(tree);
+
+  assert(list_tree_arena_count(arena) == size);
+  assert(list_tree_length(tree) == test_tree_length);
+  assert(list_tree_depth(tree) == test_tree_depth);
+  assert(NULL != find_wrapped_int(tree, 0x213));
+
+  list_tree_node_t *extra = list_tree_arena_make_singleton(arena, NULL);
+  list_tree_prepend(&tree, extra);
+
+  disposed_count = 0;
+  list_tree_arena_release(arena, counting_disposer);
+
+  assert(disposed_count == size + 1);
+
+  size_t free_before_create = heap_free_size();
+
+  arena = list_tree_arena_create(0);
+  make_wrapped_int_tree_in_arena(arena, test_tree_length, test_tree_depth);
+  list_tree_arena_release(arena, NULL);
+
+  assert(free_before_create == heap_free_size());
+}
+
+static
+int
+same_output(
+    FILE *a,
+    FILE *b)
+{
+  rewind(a);
+  rewind(b);
+
+  int c;
+  do
+  {
+    c = fgetc(a);
+    if (c != fgetc(b))
+      return 0;
+  }
+  while (EOF != c);
+
+  return 1;
+}
+
+static
+void
+test_frozen()
+{
+  list_tree_node_t *tree = make_test_object();
+  list_tree_frozen_t *frozen = list_tree_freeze(tree);
+
+  assert(list_tree_frozen_size(frozen) == list_tree_size(tree));
+  assert(list_tree_frozen_length(frozen) == test_tree_length);
+  assert(list_tree_frozen_depth(frozen) == test_tree_depth);
+
+  size_t found = list_tree_frozen_find(
+      frozen,
+      wrapped_int_comparer,
+      (void*) (long) 0x213);
+
+  assert(LIST_TREE_FROZEN_NONE != found);
+  assert(0x213 == (int) (long) list_tree_frozen_get_data(frozen, found));
+  assert(list_tree_frozen_get_subtree_end(frozen, found) == found + 1 + test_tree_length);
+
+  assert(LIST_TREE_FROZEN_NONE == list_tree_frozen_find(
+      frozen,
+      wrapped_int_comparer,
+      (void*) (long) 0x273));
+
+  static const size_t path[] = { 1, 0, 2, 1, 2, 5 };
+
+  size_t located = list_tree_frozen_locate(frozen, path, 4);
+
+  assert(LIST_TREE_FROZEN_NONE != located);
+  assert(0x2132 == (int) (long) list_tree_frozen_get_data(frozen, located));
+  assert(LIST_TREE_FROZEN_NONE == list_tree_frozen_locate(frozen, path, 6));
+
+  FILE *linked_output = tmpfile();
+  FILE *frozen_output = tmpfile();
+
+  list_tree_write(tree, wrapped_int_writer, linked_output, "\t", "{\n", "}\n");
+  list_tree_frozen_write(frozen, wrapped_int_writer, frozen_output, "\t", "{\n", "}\n");
+
+  assert(same_output(linked_output, frozen_output));
+
+  list_tree_node_t *thawed = list_tree_thaw(frozen);
+
+  FILE *thawed_output = tmpfile();
+  list_tree_write(thawed, wrapped_int_writer, thawed_output, "\t", "{\n", "}\n");
+
+  assert(same_output(linked_output, thawed_output));
+
+  fclose(linked_output);
+  fclose(frozen_output);
+  fclose(thawed_output);
+
+  list_tree_dispose(thawed, NULL);
+  list_tree_frozen_dispose(frozen, NULL);
+  list_tree_dispose(tree, NULL);
+}
+
+static
+void
+test_parallel()
+{
+  static const size_t thread_count = 4;
+
+  list_tree_node_t *tree = make_wrapped_int_tree(10, 5);
+
+  assert(list_tree_size_parallel(tree, thread_count) == list_tree_size(tree));
+  assert(list_tree_size_parallel(tree, 1) == list_tree_size(tree));
+
+  list_tree_node_t *good_node = list_tree_find_parallel(
+      tree,
+      wrapped_int_comparer,
+      (void*) (long) 0x5A3A1,
+      thread_count);
+
+  assert(NULL != good_node);
+  assert(0x5A3A1 == (int) (long) list_tree_get_data(good_node));
+
+  assert(NULL == list_tree_find_parallel(
+      tree,
+      wrapped_int_comparer,
+      (void*) (long) 0x5B3A1,
+      thread_count));
+
+  list_tree_dispose(tree, NULL);
+
+  list_tree_node_t *list = make_long_list(test_long_list_length);
+
+  assert(list_tree_size_parallel(list, 0) == test_long_list_length);
+
+  list_tree_dispose(list, NULL);
+}
+
+/*
+  Checks the context against the path; the data of a node is its
+  depth, and the scratch slot counts the nodes of the list.
+*/
+static
+int
+context_checking_generator(
+    generator_context_t const* context,
+    void *state,
+    void **data)
+{
+  size_t depth = 0;
+  for (path_item_t const* item = context->path->prev; NULL != item; item = item->prev)
+    ++ depth;
+
+  assert(context->depth == depth);
+  assert(context->index == context->path->index);
+  assert((size_t) *context->scratch == context->index);
+
+  if (0 == depth)
+    assert(NULL == context->parent_data);
+  else
+    assert((size_t) context->parent_data == depth - 1);
+
+  if (context->index == 3 || depth == 4)
+    return 0;
+
+  *context->scratch = (void*) (context->index + 1);
+  *data = (void*) depth;
+  return 1;
+}
+
+/* A chain down to the depth in state; the data of a node is its depth */
+static
+int
+chain_generator(
+    path_item_t const* path,
+    void *state,
+    void **data)
+{
+  size_t depth = 0;
+  for (path_item_t const* item = path->prev; NULL != item; item = item->prev)
+    ++ depth;
+
+  if (0 != path->index || depth == *(size_t*) state)
+    return 0;
+
+  *data = (void*) depth;
+  return 1;
+}
+
+static
+void
+test_generate()
+{
+  list_tree_node_t *checked = list_tree_generate_ex(
+      context_checking_generator,
+      NULL);
+
+  assert(list_tree_size(checked) == 3 + 9 + 27 + 81);
+  assert(list_tree_depth(checked) == 4);
+
+  list_tree_dispose(checked, NULL);
+
+  list_tree_node_t *list = make_wrapped_int_tree(test_long_list_length, 1);
+
+  assert(list_tree_size(list) == test_long_list_length);
+
+  list_tree_dispose(list, NULL);
+
+  list_tree_node_t *tree = make_wrapped_int_tree(10, 5);
+  FILE *expected = tmpfile();
+
+  list_tree_write(tree, wrapped_int_writer, expected, "\t", NULL, NULL);
+
+  for (size_t thread_count = 1; thread_count <= 8; thread_count *= 2)
+  {
+    list_tree_node_t *parallel_tree = make_wrapped_int_tree_parallel(
+        NULL,
+        10,
+        5,
+        thread_count);
+    FILE *actual = tmpfile();
+
+    list_tree_write(parallel_tree, wrapped_int_writer, actual, "\t", NULL, NULL);
+    assert(same_output(expected, actual));
+
+    fclose(actual);
+    list_tree_dispose(parallel_tree, NULL);
+  }
+
+  list_tree_arena_t *arena = list_tree_arena_create(0);
+  list_tree_node_t *arena_tree = make_wrapped_int_tree_parallel(
+      arena,
+      10,
+      5,
+      4);
+
+  assert(list_tree_size(arena_tree) == list_tree_size(tree));
+  assert(list_tree_arena_count(arena) == list_tree_size(tree));
+
+  disposed_count = 0;
+  list_tree_arena_release(arena, counting_disposer);
+  assert(disposed_count == list_tree_size(tree));
+
+  /* Worker arenas take the payload size of the target */
+  arena = list_tree_arena_create_inline(0, 24);
+  arena_tree = make_wrapped_int_tree_parallel(arena, 10, 5, 4);
+
+  assert(list_tree_arena_payload_size(arena) == 24);
+  assert(list_tree_arena_count(arena) == list_tree_size(tree));
+
+  list_tree_arena_release(arena, NULL);
+
+  /* Narrow trees are expanded to a fixed depth, the pool does the rest */
+  size_t chain_depth = 1000;
+  list_tree_node_t *chain = list_tree_generate_parallel(
+      NULL,
+      chain_generator,
+      &chain_depth,
+      NULL,
+      NULL,
+      4);
+
+  assert(list_tree_size(chain) == chain_depth);
+  assert(list_tree_depth(chain) == chain_depth);
+
+  size_t depth = 0;
+  for (list_tree_node_t *node = chain; NULL != node; node = list_tree_get_first_child(node))
+    assert((size_t) list_tree_get_data(node) == depth ++);
+
+  list_tree_dispose(chain, NULL);
+
+  fclose(expected);
+  list_tree_dispose(tree, NULL);
+}
+
+static
+void
+test_locator()
+{
+  list_tree_node_t *tree = make_wrapped_int_tree(5, 4);
+  list_tree_locator_t *locator = list_tree_locator_create(2);
+
+  size_t path[4];
+
+  for (size_t i = 0; i < 6 * 6 * 6 * 6; ++i)
+  {
+    size_t rest = i;
+    for (size_t level = 0; level < 4; ++level)
+    {
+      path[level] = rest % 6;
+      rest /= 6;
+    }
+
+    for (size_t length = 0; length <= 4; ++length)
+    {
+      assert(list_tree_locate(tree, path, length) ==
+          list_tree_locator_locate(locator, tree, path, length));
+    }
+  }
+
+  list_tree_locator_dispose(locator);
+  list_tree_dispose(tree, NULL);
+
+  list_tree_node_t *list = make_long_list(test_long_list_length);
+  locator = list_tree_locator_create(0);
+
+  size_t last[] = { test_long_list_length - 1 };
+  size_t beyond[] = { test_long_list_length };
+  list_tree_node_t *last_node = list_tree_locate(list, last, 1);
+
+  for (int i = 0; i < 1000; ++i)
+    assert(last_node == list_tree_locator_locate(locator, list, last, 1));
+
+  assert(NULL == list_tree_locator_locate(locator, list, beyond, 1));
+
+  list_tree_locator_reset(locator);
+  assert(last_node == list_tree_locator_locate(locator, list, last, 1));
+
+  list_tree_locator_dispose(locator);
+  list_tree_dispose(list, NULL);
+}
+
+static
+size_t
+next_random(
+    size_t *seed)
+{
+  *seed = *seed * 6364136223846793005ULL + 1442695040888963407ULL;
+
+  return *seed >> 33;
+}
+
+static
+void
+check_augmented(
+    list_tree_node_t *tree)
+{
+  list_tree_frozen_t *frozen = list_tree_freeze(tree);
+  size_t size = list_tree_frozen_size(frozen);
+
+  assert(list_tree_size(tree) == size);
+  assert(list_tree_depth(tree) == list_tree_frozen_depth(frozen));
+
+  for (size_t i = 0; i < size; ++i)
+  {
+    assert(list_tree_get_data(list_tree_nth(tree, i)) ==
+        list_tree_frozen_get_data(frozen, i));
+  }
+
+  assert(NULL == list_tree_nth(tree, size));
+
+  list_tree_frozen_dispose(frozen, NULL);
+}
+
+static
+void
+test_augmented()
+{
+  static const size_t node_count = 2000;
+
+  list_tree_node_t **nodes = (list_tree_node_t**) malloc(
+      node_count * sizeof(list_tree_node_t*));
+  size_t seed = 1;
+
+  list_tree_node_t *tree = list_tree_make_augmented(
+      (void*) 0L,
+      NULL,
+      list_tree_make_augmented((void*) 1L, NULL, NULL));
+
+  nodes[0] = tree;
+  nodes[1] = list_tree_get_first_child(tree);
+
+  for (size_t i = 2; i < node_count; ++i)
+  {
+    list_tree_node_t *node = list_tree_make_augmented((void*) (long) i, NULL, NULL);
+    list_tree_node_t *target = nodes[next_random(&seed) % i];
+
+    switch (next_random(&seed) % 3)
+    {
+      case 0:
+        list_tree_prepend_child(target, node);
+        break;
+
+      case 1:
+        while (NULL != list_tree_get_next(target))
+          target = list_tree_get_next(target);
+
+        list_tree_append(target, node);
+        break;
+
+      default:
+        list_tree_prepend(&tree, node);
+        break;
+    }
+
+    nodes[i] = node;
+
+    if (0 == i % 250)
+      check_augmented(tree);
+  }
+
+  check_augmented(tree);
+
+  /* Appends to a long list cost no more than its depth */
+  list_tree_node_t *list = list_tree_make_augmented((void*) 0L, NULL, NULL);
+  list_tree_node_t *last = list;
+
+  for (size_t i = 1; i < test_long_list_length; ++i)
+  {
+    list_tree_node_t *node = list_tree_make_augmented((void*) (long) i, NULL, NULL);
+
+    list_tree_append(last, node);
+    last = node;
+  }
+
+  list_tree_prepend_child(last, list_tree_make_augmented((void*) -1L, NULL, NULL));
+  list_tree_prepend(&list, list_tree_make_augmented((void*) -2L, NULL, NULL));
+
+  assert(list_tree_size(list) == test_long_list_length + 2);
+  assert(list_tree_depth(list) == 2);
+  assert(list_tree_size(last) == 2);
+  assert(list_tree_depth(last) == 2);
+  assert(list_tree_get_data(list_tree_nth(list, 1)) == (void*) 0L);
+  assert(list_tree_get_data(list_tree_nth(list, test_long_list_length + 1)) == (void*) -1L);
+  assert(list_tree_get_data(list_tree_nth(last, 1)) == (void*) -1L);
+  assert(NULL == list_tree_nth(last, 2));
+
+  list_tree_dispose(list, NULL);
+
+  list_tree_node_t *plain = make_test_object();
+
+  assert(list_tree_get_data(list_tree_nth(plain, 4)) == (void*) 0x1112L);
+  assert(NULL == list_tree_nth(plain, list_tree_size(plain)));
+
+  list_tree_dispose(plain, NULL);
+  list_tree_dispose(tree, NULL);
+  free(nodes);
+}
+
+static
+size_t
+wrapped_int_encoder(
+    void const* data,
+    void *buffer,
+    size_t capacity)
+{
+  long value = (long) data;
+
+  if (sizeof(value) <= capacity)
+    memcpy(buffer, &value, sizeof(value));
+
+  return sizeof(value);
+}
+
+static
+int
+encoded_int_comparer(
+    void const* data,
+    void const* param)
+{
+  long value;
+
+  memcpy(&value, data, sizeof(value));
+
+  return (int) value == (int) (long) param;
+}
+
+static
+void
+test_binary()
+{
+  char path[] = "/tmp/list_tree_test_XXXXXX";
+  int fd = mkstemp(path);
+
+  assert(0 <= fd);
+
+  FILE *output = fdopen(fd, "wb");
+  list_tree_node_t *tree = make_test_object();
+
+  assert(list_tree_save(tree, wrapped_int_encoder, output));
+
+  fclose(output);
+
+  list_tree_mapped_t *mapped = list_tree_mapped_open(path);
+
+  assert(NULL != mapped);
+  assert(list_tree_mapped_size(mapped) == list_tree_size(tree));
+  assert(list_tree_mapped_length(mapped) == test_tree_length);
+  assert(list_tree_mapped_depth(mapped) == test_tree_depth);
+
+  list_tree_frozen_t *frozen = list_tree_freeze(tree);
+
+  for (size_t i = 0; i < list_tree_mapped_size(mapped); ++i)
+  {
+    size_t size;
+    void const* data = list_tree_mapped_get_data(mapped, i, &size);
+
+    assert(sizeof(long) == size);
+    assert(encoded_int_comparer(data, list_tree_frozen_get_data(frozen, i)));
+    assert(list_tree_mapped_get_next(mapped, i) ==
+        list_tree_frozen_get_next(frozen, i));
+    assert(list_tree_mapped_get_first_child(mapped, i) ==
+        list_tree_frozen_get_first_child(frozen, i));
+    assert(list_tree_mapped_get_subtree_end(mapped, i) ==
+        list_tree_frozen_get_subtree_end(frozen, i));
+  }
+
+  assert(list_tree_mapped_find(mapped, encoded_int_comparer, (void*) 0x213L) ==
+      list_tree_frozen_find(frozen, wrapped_int_comparer, (void*) 0x213L));
+  assert(LIST_TREE_FROZEN_NONE ==
+      list_tree_mapped_find(mapped, encoded_int_comparer, (void*) 0x273L));
+
+  static const size_t locate_path[] = { 1, 0, 2, 1, 2, 5 };
+
+  assert(list_tree_mapped_locate(mapped, locate_path, 4) ==
+      list_tree_frozen_locate(frozen, locate_path, 4));
+  assert(LIST_TREE_FROZEN_NONE ==
+      list_tree_mapped_locate(mapped, locate_path, 6));
+
+  list_tree_mapped_close(mapped);
+  list_tree_frozen_dispose(frozen, NULL);
+  list_tree_dispose(tree, NULL);
+
+  output = fopen(path, "wb");
+  fputs("not a list-tree", output);
+  fclose(output);
+
+  assert(NULL == list_tree_mapped_open(path));
+
+  unlink(path);
+}
+
+static
+int
+wrapped_int_reader(
+    char const* text,
+    size_t length,
+    void **data)
+{
+  char buffer[32];
+
+  if (length >= sizeof(buffer))
+    return 0;
+
+  memcpy(buffer, text, length);
+  buffer[length] = '\0';
+
+  char *end;
+  long value = strtol(buffer, &end, 16);
+
+  if (end == buffer || '\0' != *end)
+    return 0;
+
+  *data = (void*) value;
+
+  return 1;
+}
+
+static
+void
+check_read(
+    list_tree_node_t *tree,
+    char const* indent,
+    char const* opening_tag,
+    char const* closing_tag)
+{
+  FILE *expected = tmpfile();
+
+  list_tree_write(tree, wrapped_int_writer, expected, indent, opening_tag, closing_tag);
+
+  list_tree_node_t *read_tree;
+
+  rewind(expected);
+  assert(list_tree_read(&read_tree, wrapped_int_reader, expected, indent, opening_tag, closing_tag));
+
+  FILE *actual = tmpfile();
+
+  list_tree_write(read_tree, wrapped_int_writer, actual, indent, opening_tag, closing_tag);
+  assert(same_output(expected, actual));
+  list_tree_dispose(read_tree, NULL);
+
+  rewind(expected);
+  assert(list_tree_read_fd(&read_tree, wrapped_int_reader, fileno(expected), indent, opening_tag, closing_tag));
+  assert(list_tree_size(read_tree) == list_tree_size(tree));
+  list_tree_dispose(read_tree, NULL);
+
+  fclose(actual);
+  fclose(expected);
+}
+
+static
+void
+test_read()
+{
+  list_tree_node_t *tree = make_test_object();
+
+  check_read(tree, "\t", NULL, NULL);
+  check_read(tree, "> ", "{\n", "}\n");
+  check_read(tree, NULL, "(\n", ")\n");
+
+  list_tree_dispose(tree, NULL);
+
+  FILE *input = tmpfile();
+  list_tree_node_t *read_tree;
+
+  fputs("1\n\t\t2\n", input);
+  rewind(input);
+
+  assert(!list_tree_read(&read_tree, wrapped_int_reader, input, "\t", NULL, NULL));
+  assert(1 == list_tree_size(read_tree));
+
+  list_tree_dispose(read_tree, NULL);
+  fclose(input);
+}
+
+static
+int
+wrapped_int_sink_writer(
+    list_tree_sink_t *sink,
+    void *data)
+{
+  char buffer[32];
+  int length = sprintf(buffer, "%4lX\n", (long) data);
+
+  return list_tree_sink_put(sink, buffer, length);
+}
+
+/* Returns the number of bytes written, like fprintf */
+static
+int
+length_returning_sink_writer(
+    list_tree_sink_t *sink,
+    void *data)
+{
+  char buffer[32];
+  int length = sprintf(buffer, "%lX\n", (long) data);
+
+  return list_tree_sink_put(sink, buffer, length) ? length : 0;
+}
+
+static
+int
+file_flusher(
+    void *context,
+    char const* bytes,
+    size_t size)
+{
+  return 1 == fwrite(bytes, size, 1, (FILE*) context);
+}
+
+static
+int
+same_content(
+    FILE *file,
+    char const* bytes,
+    size_t size)
+{
+  rewind(file);
+
+  for (size_t i = 0; i < size; ++i)
+  {
+    if (fgetc(file) != (unsigned char) bytes[i])
+      return 0;
+  }
+
+  return EOF == fgetc(file);
+}
+
+static
+void
+test_sink()
+{
+  list_tree_node_t *tree = make_test_object();
+  FILE *expected = tmpfile();
+
+  list_tree_write(tree, wrapped_int_writer, expected, "\t", "{\n", "}\n");
+
+  list_tree_sink_t *memory = list_tree_sink_create_memory(16);
+
+  assert(list_tree_write_sink(tree, wrapped_int_sink_writer, memory, "\t", "{\n", "}\n"));
+
+  size_t size;
+  char const* bytes = list_tree_sink_memory(memory, &size);
+
+  assert(same_content(expected, bytes, size));
+  assert(list_tree_sink_dispose(memory));
+
+  /* Any non-0 result of the writer means success */
+  memory = list_tree_sink_create_memory(16);
+  assert(list_tree_write_sink(tree, length_returning_sink_writer, memory, "\t", "{\n", "}\n"));
+  assert(list_tree_sink_dispose(memory));
+
+  FILE *actual = tmpfile();
+  char buffer[8];
+  list_tree_sink_t *sink = list_tree_sink_create_fd(fileno(actual), buffer, sizeof(buffer));
+
+  assert(list_tree_write_sink(tree, wrapped_int_sink_writer, sink, "\t", "{\n", "}\n"));
+  assert(list_tree_sink_dispose(sink));
+  assert(same_output(expected, actual));
+  fclose(actual);
+
+  actual = tmpfile();
+  sink = list_tree_sink_create(file_flusher, actual, NULL, 0);
+
+  assert(list_tree_write_sink(tree, wrapped_int_sink_writer, sink, "\t", "{\n", "}\n"));
+  assert(list_tree_sink_dispose(sink));
+  assert(same_output(expected, actual));
+  fclose(actual);
+
+  fclose(expected);
+  list_tree_dispose(tree, NULL);
+}
+
+static
+void
+test_shapes()
+{
+  static const size_t size = 100000;
+
+  tree_shape_params_t params = { TREE_SHAPE_RANDOM, size, 6, 12, 42 };
+
+  for (int shape = TREE_SHAPE_RANDOM; shape <= TREE_SHAPE_FILE_SYSTEM; ++shape)
+  {
+    params.shape = (tree_shape_t) shape;
+
+    list_tree_node_t *tree = make_shaped_tree(NULL, &params);
+    list_tree_frozen_t *frozen = list_tree_freeze(tree);
+
+    assert(list_tree_frozen_size(frozen) == size);
+
+    for (size_t i = 0; i < size; ++i)
+      assert((long) i == (long) list_tree_frozen_get_data(frozen, i));
+
+    switch (params.shape)
+    {
+      case TREE_SHAPE_CHAIN:
+        assert(list_tree_frozen_depth(frozen) == size);
+        assert(list_tree_frozen_length(frozen) == 1);
+        break;
+
+      case TREE_SHAPE_LIST:
+        assert(list_tree_frozen_depth(frozen) == 1);
+        assert(list_tree_frozen_length(frozen) == size);
+        break;
+
+      default:
+        assert(list_tree_frozen_depth(frozen) <= params.max_depth);
+        assert(list_tree_frozen_depth(frozen) > 1);
+        break;
+    }
+
+    list_tree_frozen_dispose(frozen, NULL);
+    list_tree_dispose(tree, NULL);
+  }
+}
+
+static
+size_t
+wrapped_int_depth(
+    long key)
+{
+  size_t depth = 0;
+
+  while (0 != (key >>= 4))
+    ++ depth;
+
+  return depth;
+}
+
+static
+void
+test_cursor()
+{
+  list_tree_node_t *tree = make_wrapped_int_tree(3, 4);
+  size_t size = list_tree_size(tree);
+  list_tree_cursor_t cursor;
+
+  list_tree_cursor_init(&cursor, tree);
+  assert(NULL == list_tree_cursor_node(&cursor));
+
+  size_t count = 0;
+  while (list_tree_cursor_next_preorder(&cursor))
+  {
+    list_tree_node_t *node = list_tree_cursor_node(&cursor);
+    long key = (long) list_tree_get_data(node);
+
+    assert(node == list_tree_nth(tree, count));
+    assert(list_tree_cursor_depth(&cursor) == wrapped_int_depth(key));
+    ++ count;
+  }
+
+  assert(count == size);
+  assert(NULL == list_tree_cursor_node(&cursor));
+  assert(!list_tree_cursor_next_preorder(&cursor));
+  list_tree_cursor_dispose(&cursor);
+
+  /* A node comes after its children and before its next sibling */
+  long order[0x4000];
+  size_t positions[0x4000];
+
+  list_tree_cursor_init(&cursor, tree);
+  count = 0;
+  while (list_tree_cursor_next_postorder(&cursor))
+  {
+    long key = (long) list_tree_get_data(list_tree_cursor_node(&cursor));
+
+    assert(list_tree_cursor_depth(&cursor) == wrapped_int_depth(key));
+    order[count] = key;
+    positions[key] = count ++;
+  }
+
+  assert(count == size);
+  assert(0x1111 == order[0]);
+  assert(0x3 == order[count - 1]);
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    long key = order[i];
+
+    if (key > 0xF)
+      assert(positions[key >> 4] > i);
+
+    if (1 != (key & 0xF))
+      assert(positions[key - 1] < i);
+  }
+
+  list_tree_cursor_dispose(&cursor);
+
+  /* Single steps */
+  list_tree_cursor_init(&cursor, tree);
+  assert(list_tree_cursor_next_preorder(&cursor));
+  assert(!list_tree_cursor_up(&cursor));
+  assert(list_tree_cursor_advance(&cursor));
+  assert(list_tree_cursor_descend(&cursor));
+  assert(list_tree_cursor_advance(&cursor));
+  assert(list_tree_cursor_advance(&cursor));
+  assert(!list_tree_cursor_advance(&cursor));
+  assert(0x23 == (long) list_tree_get_data(list_tree_cursor_node(&cursor)));
+  assert(1 == list_tree_cursor_depth(&cursor));
+  assert(list_tree_cursor_next_postorder(&cursor));
+  assert(0x2 == (long) list_tree_get_data(list_tree_cursor_node(&cursor)));
+  assert(list_tree_cursor_next_preorder(&cursor));
+  assert(0x21 == (long) list_tree_get_data(list_tree_cursor_node(&cursor)));
+  assert(list_tree_cursor_up(&cursor));
+  assert(0 == list_tree_cursor_depth(&cursor));
+  list_tree_cursor_dispose(&cursor);
+
+  /* Deep chains need no call stack */
+  list_tree_node_t *chain = make_long_chain(test_long_list_length);
+
+  list_tree_cursor_init(&cursor, chain);
+  count = 0;
+  while (list_tree_cursor_next_postorder(&cursor))
+    ++ count;
+
+  assert(count == test_long_list_length);
+  list_tree_cursor_dispose(&cursor);
+
+  list_tree_cursor_init(&cursor, NULL);
+  assert(!list_tree_cursor_next_preorder(&cursor));
+  list_tree_cursor_dispose(&cursor);
+
+  list_tree_cursor_init(&cursor, NULL);
+  assert(!list_tree_cursor_next_postorder(&cursor));
+  list_tree_cursor_dispose(&cursor);
+
+  list_tree_dispose(chain, NULL);
+  list_tree_dispose(tree, NULL);
+}
+
+typedef struct _breadth_state_t
+{
+  long last_key;
+  size_t depth;
+  size_t level_size;
+  size_t level_sizes[8];
+  size_t max_depth;
+} breadth_state_t;
+
+static
+int
+breadth_level_begin(
+    size_t depth,
+    void *raw_state)
+{
+  breadth_state_t *state = (breadth_state_t*) raw_state;
+
+  state->depth = depth;
+  state->level_size = 0;
+
+  return depth < state->max_depth;
+}
+
+static
+int
+breadth_visitor(
+    list_tree_node_t *node,
+    void *raw_state)
+{
+  breadth_state_t *state = (breadth_state_t*) raw_state;
+  long key = (long) list_tree_get_data(node);
+
+  /* Levels come in order of the number of digits, and within a
+     level, keys grow from left to right */
+  assert(key > state->last_key);
+  assert(wrapped_int_depth(key) == state->depth);
+
+  state->last_key = key;
+  ++ state->level_size;
+
+  return (key & 0xF) != 2;
+}
+
+static
+void
+breadth_level_end(
+    size_t depth,
+    void *raw_state)
+{
+  breadth_state_t *state = (breadth_state_t*) raw_state;
+
+  assert(depth == state->depth);
+  state->level_sizes[depth] = state->level_size;
+}
+
+static
+int
+last_digit_comparer(
+    void const* data,
+    void const* param)
+{
+  return ((long) data & 0xF) == (long) param;
+}
+
+static
+void
+test_breadth()
+{
+  list_tree_node_t *tree = make_wrapped_int_tree(3, 4);
+  list_tree_queue_t *queue = list_tree_queue_create();
+
+  /* Subtrees of nodes ending with 2 are skipped */
+  for (size_t max_depth = 2; max_depth <= 5; max_depth += 3)
+  {
+    breadth_state_t state = { 0, 0, 0, { 0 }, max_depth };
+
+    list_tree_traverse_breadth(
+        tree,
+        queue,
+        breadth_level_begin,
+        breadth_visitor,
+        breadth_level_end,
+        &state);
+
+    assert(3 == state.level_sizes[0]);
+    assert(6 == state.level_sizes[1]);
+    assert((2 == max_depth ? 0 : 12) == state.level_sizes[2]);
+    assert((2 == max_depth ? 0 : 24) == state.level_sizes[3]);
+    assert(0 == state.level_sizes[4]);
+  }
+
+  /* Wider levels make the queue wrap around and grow */
+  list_tree_node_t *wide_tree = make_wrapped_int_tree(9, 4);
+  breadth_state_t state = { 0, 0, 0, { 0 }, 8 };
+
+  list_tree_traverse_breadth(
+      wide_tree,
+      queue,
+      breadth_level_begin,
+      breadth_visitor,
+      breadth_level_end,
+      &state);
+
+  assert(9 == state.level_sizes[0]);
+  assert(8 * 9 == state.level_sizes[1]);
+  assert(8 * 8 * 9 == state.level_sizes[2]);
+  assert(8 * 8 * 8 * 9 == state.level_sizes[3]);
+
+  list_tree_dispose(wide_tree, NULL);
+  list_tree_queue_dispose(queue);
+
+  /* Depth-first search finds a deep node first */
+  assert(0x1112 == (long) list_tree_get_data(list_tree_find(
+      tree,
+      last_digit_comparer,
+      (void*) 2L)));
+
+  assert(0x2 == (long) list_tree_get_data(list_tree_find_nearest(
+      tree,
+      last_digit_comparer,
+      (void*) 2L)));
+
+  assert(NULL == list_tree_find_nearest(
+      tree,
+      last_digit_comparer,
+      (void*) 7L));
+
+  list_tree_dispose(tree, NULL);
+
+  /* A wide level takes a single place in the queue */
+  list_tree_node_t *list = make_long_list(test_long_list_length);
+
+  assert(list_tree_find_nearest(list, last_digit_comparer, (void*) -1L) == NULL);
+
+  list_tree_dispose(list, NULL);
+
+  assert(NULL == list_tree_find_nearest(NULL, last_digit_comparer, NULL));
+}
+
+/*
+  Same keys as make_wrapped_int_tree, from the path alone, for
+  lists of 10 nodes and the depth given by the state.
+*/
+static
+int
+lazy_wrapped_int_generator(
+    path_item_t const* path,
+    void *state,
+    void **data)
+{
+  size_t max_depth = *(size_t const*) state;
+  long key = 0;
+  size_t depth = 0;
+
+  if (10 == path->index)
+    return 0;
+
+  for (path_item_t const* item = path; NULL != item; item = item->prev)
+    key += (long) (1 + item->index) << (4 * depth ++);
+
+  if (max_depth < depth)
+    return 0;
+
+  *data = (void*) key;
+  return 1;
+}
+
+static
+void
+test_lazy()
+{
+  static size_t const far_path[] = { 9, 9, 9, 9, 9, 9, 9, 9 };
+  static size_t const near_path[] = { 0, 0, 0 };
+  static size_t const far_depth = 8;
+  static size_t const near_depth = 3;
+
+  list_tree_node_t *tree = list_tree_generate_lazy(
+      lazy_wrapped_int_generator,
+      (void*) &far_depth);
+
+  assert(1 == list_tree_lazy_count(tree));
+
+  /* Of 10^8 virtual nodes, only those on the way are generated */
+  list_tree_node_t *node = list_tree_locate(tree, far_path, 8);
+
+  assert(0xAAAAAAAA == (long) list_tree_get_data(node));
+  assert(80 == list_tree_lazy_count(tree));
+  assert(NULL == list_tree_get_first_child(node));
+  assert(80 == list_tree_lazy_count(tree));
+
+  /* Trimming cannot go below the root list */
+  assert(10 == list_tree_lazy_trim(tree, 0, NULL));
+
+  node = list_tree_locate(tree, far_path, 8);
+  assert(0xAAAAAAAA == (long) list_tree_get_data(node));
+  assert(80 == list_tree_lazy_count(tree));
+  assert(10 == list_tree_lazy_trim(tree, 0, NULL));
+
+  /* The least recently visited subtree goes first */
+  list_tree_locate(tree, near_path, 3);
+  list_tree_locate(tree, far_path, 3);
+  assert(32 == list_tree_lazy_count(tree));
+
+  assert(30 == list_tree_lazy_trim(tree, 30, NULL));
+  list_tree_locate(tree, far_path, 3);
+  assert(30 == list_tree_lazy_count(tree));
+  list_tree_locate(tree, near_path, 3);
+  assert(32 == list_tree_lazy_count(tree));
+
+  /* Counting the root list generates nothing more */
+  assert(10 == list_tree_length(tree));
+  assert(32 == list_tree_lazy_count(tree));
+
+  list_tree_dispose(tree, NULL);
+
+  /* Full traversals see the same tree as the eager generation */
+  list_tree_node_t *eager = make_wrapped_int_tree(10, 3);
+  list_tree_node_t *lazy = list_tree_generate_lazy(
+      lazy_wrapped_int_generator,
+      (void*) &near_depth);
+  FILE *expected = tmpfile();
+  FILE *actual = tmpfile();
+
+  list_tree_write(eager, wrapped_int_writer, expected, "\t", NULL, NULL);
+  list_tree_write(lazy, wrapped_int_writer, actual, "\t", NULL, NULL);
+  assert(same_output(expected, actual));
+
+  assert(1110 == list_tree_lazy_count(lazy));
+
+  list_tree_node_t *nearest = list_tree_find_nearest(
+      lazy,
+      wrapped_int_comparer,
+      (void*) 0x111L);
+
+  assert(0x111 == (long) list_tree_get_data(nearest));
+
+  list_tree_dispose(lazy, NULL);
+  fclose(actual);
+  fclose(expected);
+  list_tree_dispose(eager, NULL);
+}
+
+typedef struct _record_t
+{
+  long key;
+  char name[12];
+} record_t;
+
+static
+int
+record_comparer(
+    void const* data,
+    void const* param)
+{
+  return ((record_t const*) data)->key == (long) param;
+}
+
+static
+void
+test_inline()
+{
+  static size_t const count = 1000;
+  list_tree_node_t *list = NULL;
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    record_t record = { (long) i, "record" };
+
+    list_tree_prepend(&list, list_tree_make_inline(
+        &record,
+        sizeof(record_t),
+        NULL,
+        NULL));
+  }
+
+  list_tree_node_t *child = list_tree_make_inline(
+      NULL,
+      sizeof(record_t),
+      NULL,
+      NULL);
+
+  assert(0 == ((record_t*) list_tree_get_payload(child))->key);
+  list_tree_prepend_child(list, child);
+
+  list_tree_node_t *found = list_tree_find(list, record_comparer, (void*) 10L);
+  record_t *record = (record_t*) list_tree_get_payload(found);
+
+  assert(list_tree_get_data(found) == record);
+  assert((char*) record > (char*) found);
+  assert((char*) record < (char*) found + 64);
+  assert(10 == record->key);
+  assert(0 == strcmp("record", record->name));
+  assert(list_tree_size(list) == count + 1);
+
+  /* Payloads go away with their nodes */
+  disposed_count = 0;
+  list_tree_dispose(list, counting_disposer);
+  assert(0 == disposed_count);
+
+  list_tree_arena_t *arena = list_tree_arena_create_inline(16, sizeof(record_t));
+  list_tree_node_t *arena_list = NULL;
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    record_t arena_record = { (long) i, "" };
+
+    list_tree_prepend(&arena_list, list_tree_arena_make_inline(
+        arena,
+        &arena_record,
+        NULL,
+        NULL));
+  }
+
+  list_tree_prepend(&arena_list, list_tree_arena_make(arena, NULL, NULL, NULL));
+
+  size_t expected_key = count;
+  list_tree_node_t *node = list_tree_get_next(arena_list);
+
+  for (; NULL != node; node = list_tree_get_next(node))
+  {
+    record_t *arena_record = (record_t*) list_tree_get_payload(node);
+
+    assert((long) -- expected_key == arena_record->key);
+  }
+
+  assert(0 == expected_key);
+
+  assert(list_tree_arena_count(arena) == count + 1);
+
+  disposed_count = 0;
+  list_tree_arena_release(arena, counting_disposer);
+  assert(1 == disposed_count);
+}
+
+/* Same tree as make_wrapped_int_tree(3, 3), made persistent */
+static
+list_tree_node_t*
+make_persistent_tree()
+{
+  list_tree_node_t *root = NULL;
+  size_t path[2];
+
+  for (long i = 3; 0 != i; --i)
+    list_tree_persistent_prepend_child(&root, NULL, 0, (void*) i);
+
+  for (path[0] = 0; path[0] < 3; ++ path[0])
+  {
+    for (long j = 3; 0 != j; --j)
+    {
+      long key = (long) (1 + path[0]) << 4 | j;
+      list_tree_persistent_prepend_child(&root, path, 1, (void*) key);
+    }
+
+    for (path[1] = 0; path[1] < 3; ++ path[1])
+    {
+      for (long k = 3; 0 != k; --k)
+      {
+        long key = ((long) (1 + path[0]) << 8) | ((long) (1 + path[1]) << 4) | k;
+        list_tree_persistent_prepend_child(&root, path, 2, (void*) key);
+      }
+    }
+  }
+
+  return root;
+}
+
+typedef struct _snapshot_reader_t
+{
+  list_tree_node_t *snapshot;
+  size_t size;
+} snapshot_reader_t;
+
+static
+void*
+read_snapshot(
+    void *raw_reader)
+{
+  snapshot_reader_t *reader = (snapshot_reader_t*) raw_reader;
+
+  reader->size = list_tree_size(reader->snapshot);
+  list_tree_snapshot_release(reader->snapshot);
+
+  return NULL;
+}
+
+static
+void
+test_persistent()
+{
+  static size_t const path[] = { 2, 1 };
+  static size_t const last_path[] = { 2, 2 };
+  static size_t const middle_path[] = { 1 };
+
+  list_tree_node_t *tree = make_persistent_tree();
+  list_tree_node_t *expected_tree = make_wrapped_int_tree(3, 3);
+  FILE *expected = tmpfile();
+  FILE *actual = tmpfile();
+
+  list_tree_write(expected_tree, wrapped_int_writer, expected, "\t", NULL, NULL);
+  list_tree_write(tree, wrapped_int_writer, actual, "\t", NULL, NULL);
+  assert(same_output(expected, actual));
+
+  /* Changes do not show through a snapshot */
+  list_tree_node_t *snapshot = list_tree_snapshot(tree);
+
+  assert(snapshot == tree);
+  list_tree_persistent_set_data(&tree, path, 2, (void*) 0x99L);
+  list_tree_persistent_append(&tree, last_path, 2, (void*) 0x34L);
+
+  assert(0x99 == (long) list_tree_get_data(list_tree_locate(tree, path, 2)));
+  assert(0x32 == (long) list_tree_get_data(list_tree_locate(snapshot, path, 2)));
+  assert(list_tree_size(tree) == list_tree_size(snapshot) + 1);
+
+  FILE *snapshot_output = tmpfile();
+
+  list_tree_write(snapshot, wrapped_int_writer, snapshot_output, "\t", NULL, NULL);
+  assert(same_output(expected, snapshot_output));
+  fclose(snapshot_output);
+
+  /* Only the way to the change is copied */
+  assert(snapshot != tree);
+  assert(list_tree_get_first_child(snapshot) == list_tree_get_first_child(tree));
+  assert(list_tree_locate(snapshot, path, 1) != list_tree_locate(tree, path, 1));
+  assert(list_tree_get_first_child(list_tree_locate(snapshot, path, 1)) !=
+      list_tree_get_first_child(list_tree_locate(tree, path, 1)));
+  assert(list_tree_get_first_child(list_tree_locate(snapshot, middle_path, 1)) ==
+      list_tree_get_first_child(list_tree_locate(tree, middle_path, 1)));
+
+  /* Unshared nodes are changed in place */
+  list_tree_snapshot_release(snapshot);
+
+  list_tree_node_t *node = list_tree_locate(tree, path, 2);
+
+  list_tree_persistent_set_data(&tree, path, 2, (void*) 0x32L);
+  assert(node == list_tree_locate(tree, path, 2));
+
+  /* Readers work on snapshots while the tree changes */
+  snapshot_reader_t readers[4];
+  pthread_t threads[4];
+
+  for (size_t i = 0; i < 4; ++i)
+  {
+    readers[i].snapshot = list_tree_snapshot(tree);
+    pthread_create(&threads[i], NULL, read_snapshot, &readers[i]);
+    list_tree_persistent_prepend_child(&tree, path, 1, (void*) 0x30L);
+  }
+
+  for (size_t i = 0; i < 4; ++i)
+  {
+    pthread_join(threads[i], NULL);
+    assert(readers[i].size == 40 + i);
+  }
+
+  assert(44 == list_tree_size(tree));
+
+  list_tree_snapshot_release(tree);
+  fclose(actual);
+  fclose(expected);
+  list_tree_dispose(expected_tree, NULL);
+}
+
+enum { CONCURRENT_THREADS = 4, CONCURRENT_INSERTIONS = 10000 };
+
+typedef struct _concurrent_writer_t
+{
+  list_tree_node_t *shared_parent;
+  list_tree_node_t *own_parent;
+  long first_key;
+} concurrent_writer_t;
+
+static
+void*
+insert_concurrently(
+    void *raw_writer)
+{
+  concurrent_writer_t *writer = (concurrent_writer_t*) raw_writer;
+
+  for (long i = 0; i < CONCURRENT_INSERTIONS; ++i)
+  {
+    list_tree_node_t *parent = 0 == i % 2
+      ? writer->shared_parent
+      : writer->own_parent;
+
+    list_tree_prepend_child_concurrent(
+        parent,
+        list_tree_make_singleton((void*) (writer->first_key + i)));
+  }
+
+  return NULL;
+}
+
+typedef struct _concurrent_reader_t
+{
+  list_tree_node_t *root;
+  int const* is_done;
+  size_t last_size;
+} concurrent_reader_t;
+
+static
+int
+concurrent_key_checker(
+    list_tree_node_t *node,
+    void *_)
+{
+  long key = (long) list_tree_get_data(node);
+
+  assert(key >= 0 && key < CONCURRENT_THREADS * CONCURRENT_INSERTIONS);
+  return 1;
+}
+
+static
+void*
+read_concurrently(
+    void *raw_reader)
+{
+  concurrent_reader_t *reader = (concurrent_reader_t*) raw_reader;
+
+  while (!__atomic_load_n(reader->is_done, __ATOMIC_ACQUIRE))
+  {
+    size_t size = list_tree_size(reader->root);
+
+    assert(size >= reader->last_size);
+    reader->last_size = size;
+
+    list_tree_traverse_depth(
+        reader->root,
+        concurrent_key_checker,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        NULL);
+  }
+
+  return NULL;
+}
+
+static
+void
+test_concurrent()
+{
+  list_tree_node_t *root = list_tree_make_singleton((void*) 0L);
+  concurrent_writer_t writers[CONCURRENT_THREADS];
+  pthread_t writer_threads[CONCURRENT_THREADS];
+  int is_done = 0;
+  concurrent_reader_t reader = { root, &is_done, 0 };
+  pthread_t reader_thread;
+
+  /* Every writer has a parent of its own, and all share the root */
+  for (long i = 0; i < CONCURRENT_THREADS; ++i)
+  {
+    writers[i].shared_parent = root;
+    writers[i].own_parent = list_tree_make_singleton((void*) 0L);
+    writers[i].first_key = i * CONCURRENT_INSERTIONS;
+    list_tree_append(
+        0 == i ? root : writers[i - 1].own_parent,
+        writers[i].own_parent);
+  }
+
+  pthread_create(&reader_thread, NULL, read_concurrently, &reader);
+
+  for (size_t i = 0; i < CONCURRENT_THREADS; ++i)
+    pthread_create(&writer_threads[i], NULL, insert_concurrently, &writers[i]);
+
+  for (size_t i = 0; i < CONCURRENT_THREADS; ++i)
+    pthread_join(writer_threads[i], NULL);
+
+  __atomic_store_n(&is_done, 1, __ATOMIC_RELEASE);
+  pthread_join(reader_thread, NULL);
+
+  size_t const total = CONCURRENT_THREADS * CONCURRENT_INSERTIONS;
+
+  assert(list_tree_size(root) == 1 + CONCURRENT_THREADS + total);
+  assert(list_tree_size(list_tree_get_first_child(root)) == total / 2);
+
+  /* No insertion is lost: every key is there exactly once */
+  char *seen = (char*) calloc(total, 1);
+
+  assert(NULL != seen);
+
+  for (list_tree_node_t *parent = root; NULL != parent; parent = list_tree_get_next(parent))
+  {
+    list_tree_node_t *child = list_tree_get_first_child(parent);
+
+    for (; NULL != child; child = list_tree_get_next(child))
+    {
+      long key = (long) list_tree_get_data(child);
+
+      assert(!seen[key]);
+      seen[key] = 1;
+    }
+  }
+
+  for (size_t i = 0; i < total; ++i)
+    assert(seen[i]);
+
+  free(seen);
+  list_tree_dispose(root, NULL);
+}
+
+static
+void
+test_builder()
+{
+  /* Depth-first, in natural order */
+  list_tree_builder_t *builder = list_tree_builder_create(NULL);
+
+  assert(NULL == list_tree_builder_root(builder));
+
+  for (long i = 1; i <= 3; ++i)
+  {
+    list_tree_node_t *node = list_tree_builder_append_child(
+        builder,
+        NULL,
+        list_tree_make_singleton((void*) i));
+
+    for (long j = 1; j <= 3; ++j)
+    {
+      list_tree_node_t *child = list_tree_builder_append_child(
+          builder,
+          node,
+          list_tree_make_singleton((void*) (i << 4 | j)));
+
+      for (long k = 1; k <= 3; ++k)
+      {
+        list_tree_builder_append_child(
+            builder,
+            child,
+            list_tree_make_singleton((void*) (i << 8 | j << 4 | k)));
+      }
+    }
+  }
+
+  list_tree_node_t *tree = list_tree_builder_root(builder);
+  list_tree_node_t *expected_tree = make_wrapped_int_tree(3, 3);
+  FILE *expected = tmpfile();
+  FILE *actual = tmpfile();
+
+  list_tree_write(expected_tree, wrapped_int_writer, expected, "\t", NULL, NULL);
+  list_tree_write(tree, wrapped_int_writer, actual, "\t", NULL, NULL);
+  assert(same_output(expected, actual));
+
+  fclose(actual);
+  fclose(expected);
+  list_tree_builder_dispose(builder);
+  list_tree_dispose(expected_tree, NULL);
+
+  /* Lists built elsewhere are continued, and chains go in whole */
+  static size_t const path[] = { 2, 2 };
+  list_tree_node_t *parent = list_tree_locate(tree, path, 2);
+  list_tree_node_t *chain = make_long_list(test_long_list_length);
+
+  builder = list_tree_builder_create(tree);
+  list_tree_builder_append_chain(builder, parent, chain, NULL);
+  list_tree_builder_append_child(builder, parent, list_tree_make_singleton(NULL));
+  list_tree_builder_append_chain(builder, NULL, make_long_list(10), NULL);
+
+  assert(list_tree_length(list_tree_get_first_child(parent)) ==
+      3 + test_long_list_length + 1);
+  assert(list_tree_length(tree) == 3 + 10);
+
+  /* Long lists grow in linear time */
+  list_tree_node_t *wide_parent = list_tree_make_singleton(NULL);
+
+  for (size_t i = 0; i < test_long_list_length; ++i)
+  {
+    list_tree_builder_append_child(
+        builder,
+        wide_parent,
+        list_tree_make_singleton((void*) i));
+  }
+
+  list_tree_builder_append_child(builder, NULL, wide_parent);
+  assert(list_tree_size(wide_parent) == test_long_list_length + 1);
+  assert(tree == list_tree_builder_root(builder));
+
+  list_tree_builder_dispose(builder);
+  list_tree_dispose(tree, NULL);
+}
+
+static
+void
+test_reclaimer()
+{
+  /*
+    Steps do exactly the budget until the trees run out: a unit
+    for each node freed, and one for each node not in a root list
+    moved out of the way.
+  */
+  list_tree_reclaimer_t *reclaimer = list_tree_reclaimer_create(0);
+  list_tree_node_t *tree = make_wrapped_int_tree(5, 5);
+  size_t size = list_tree_size(tree);
+  size_t work = 2 * size - list_tree_length(tree);
+
+  disposed_count = 0;
+  list_tree_dispose_async(reclaimer, tree, counting_disposer);
+  list_tree_dispose_async(reclaimer, make_long_chain(test_long_list_length), NULL);
+  list_tree_dispose_async(reclaimer, make_long_list(10), counting_disposer);
+
+  assert(0 == disposed_count);
+  assert(100 == list_tree_dispose_step(reclaimer, 100));
+  assert(0 < disposed_count && disposed_count < 100);
+
+  size_t done = 100;
+  size_t step;
+
+  while (1000 == (step = list_tree_dispose_step(reclaimer, 1000)))
+    done += step;
+
+  done += step;
+  assert(work + 2 * test_long_list_length - 1 + 10 == done);
+  assert(size + 10 == disposed_count);
+  assert(0 == list_tree_dispose_step(reclaimer, 1000));
+
+  /* A long chain is freed in steps of a single unit */
+  disposed_count = 0;
+  list_tree_dispose_async(
+      reclaimer,
+      make_long_chain(test_long_list_length),
+      counting_disposer);
+
+  for (size_t i = 1; i < test_long_list_length; ++i)
+    assert(1 == list_tree_dispose_step(reclaimer, 1));
+
+  assert(0 == disposed_count);
+
+  for (size_t i = 0; i < test_long_list_length; ++i)
+    assert(1 == list_tree_dispose_step(reclaimer, 1));
+
+  assert(test_long_list_length == disposed_count);
+  assert(0 == list_tree_dispose_step(reclaimer, 1));
+
+  list_tree_reclaimer_dispose(reclaimer);
+
+  /* A background thread frees everything before the flush returns */
+  reclaimer = list_tree_reclaimer_create(1);
+  disposed_count = 0;
+
+  for (size_t i = 0; i < 10; ++i)
+    list_tree_dispose_async(reclaimer, make_wrapped_int_tree(5, 5), counting_disposer);
+
+  list_tree_reclaimer_flush(reclaimer);
+  assert(10 * size == disposed_count);
+
+  list_tree_dispose_async(reclaimer, make_long_chain(test_long_list_length), NULL);
+  list_tree_reclaimer_dispose(reclaimer);
+}
+
+static
+void
+check_same_stats(
+    list_tree_stats_t const* a,
+    list_tree_stats_t const* b)
+{
+  assert(a->size == b->size);
+  assert(a->length == b->length);
+  assert(a->depth == b->depth);
+  assert(a->longest_run == b->longest_run);
+  assert(a->memory == b->memory);
+  assert(0 == memcmp(a->level_sizes, b->level_sizes, a->depth * sizeof(size_t)));
+  assert(0 == memcmp(a->fan_out, b->fan_out, sizeof(a->fan_out)));
+}
+
+static
+void
+test_stats()
+{
+  list_tree_node_t *tree = make_wrapped_int_tree(3, 4);
+  list_tree_stats_t stats;
+  list_tree_stats_t parallel_stats;
+
+  list_tree_stats(tree, &stats);
+
+  assert(120 == stats.size);
+  assert(3 == stats.length);
+  assert(4 == stats.depth);
+  assert(3 == stats.level_sizes[0]);
+  assert(9 == stats.level_sizes[1]);
+  assert(27 == stats.level_sizes[2]);
+  assert(81 == stats.level_sizes[3]);
+  assert(81 == stats.fan_out[0]);
+  assert(39 == stats.fan_out[2]);
+  assert(3 == stats.longest_run);
+  assert(0 == stats.memory % 120);
+
+  for (size_t thread_count = 1; thread_count <= 8; thread_count *= 2)
+  {
+    list_tree_stats_parallel(tree, thread_count, &parallel_stats);
+    check_same_stats(&stats, &parallel_stats);
+    list_tree_stats_dispose(&parallel_stats);
+  }
+
+  list_tree_stats_dispose(&stats);
+  list_tree_dispose(tree, NULL);
+
+  for (tree_shape_t shape = TREE_SHAPE_RANDOM; shape <= TREE_SHAPE_FILE_SYSTEM; ++shape)
+  {
+    tree_shape_params_t params = { shape, 10000, 8, 12, 42 };
+    list_tree_node_t *shaped = make_shaped_tree(NULL, &params);
+    size_t fan_out_total = 0;
+
+    list_tree_stats(shaped, &stats);
+
+    assert(stats.size == list_tree_size(shaped));
+    assert(stats.length == list_tree_length(shaped));
+    assert(stats.depth == list_tree_depth(shaped));
+
+    for (size_t i = 0; i < LIST_TREE_FAN_OUT_BUCKETS; ++i)
+      fan_out_total += stats.fan_out[i];
+
+    assert(fan_out_total == stats.size);
+
+    list_tree_stats_parallel(shaped, 4, &parallel_stats);
+    check_same_stats(&stats, &parallel_stats);
+
+    list_tree_stats_dispose(&parallel_stats);
+    list_tree_stats_dispose(&stats);
+    list_tree_dispose(shaped, NULL);
+  }
+
+  /* Metadata of variants counts */
+  list_tree_node_t *plain = list_tree_make_singleton(NULL);
+  list_tree_node_t *augmented = list_tree_make_augmented(NULL, NULL, NULL);
+
+  list_tree_stats(plain, &stats);
+  list_tree_stats(augmented, &parallel_stats);
+  assert(stats.memory < parallel_stats.memory);
+
+  list_tree_stats_dispose(&parallel_stats);
+  list_tree_stats_dispose(&stats);
+  list_tree_dispose(augmented, NULL);
+  list_tree_dispose(plain, NULL);
+
+  list_tree_node_t *list = make_long_list(test_long_list_length);
+
+  list_tree_stats(list, &stats);
+  assert(test_long_list_length == stats.longest_run);
+  assert(1 == stats.depth);
+  list_tree_stats_dispose(&stats);
+  list_tree_dispose(list, NULL);
+
+  list_tree_stats(NULL, &stats);
+  assert(0 == stats.size && 0 == stats.depth && 0 == stats.length);
+  list_tree_stats_dispose(&stats);
+}
+
+/*
+  Records all calls it gets, pruning by its own rules: children
+  below max_depth, nodes whose key ends with skip_digit, and every
+  forward_period-th move forward.
+*/
+typedef struct _recording_state_t
+{
+  size_t max_depth;
+  long skip_digit;
+  size_t forward_period;
+  size_t depth;
+  size_t forward_count;
+  size_t size;
+  long events[2048];
+} recording_state_t;
+
+static
+void
+record_event(
+    recording_state_t *state,
+    long event)
+{
+  assert(state->size < sizeof(state->events) / sizeof(long));
+  state->events[state->size ++] = event;
+}
+
+static
+int
+recording_pre_visitor(
+    list_tree_node_t *node,
+    void *raw_state)
+{
+  recording_state_t *state = (recording_state_t*) raw_state;
+  long key = (long) list_tree_get_data(node);
+
+  record_event(state, key);
+  return (key & 0xF) != state->skip_digit;
+}
+
+static
+int
+recording_descent(
+    void *raw_state)
+{
+  recording_state_t *state = (recording_state_t*) raw_state;
+
+  record_event(state, -1);
+
+  if (state->depth + 1 >= state->max_depth)
+    return 0;
+
+  ++ state->depth;
+  return 1;
+}
+
+static
+void
+recording_ascent(
+    void *raw_state)
+{
+  recording_state_t *state = (recording_state_t*) raw_state;
+
+  -- state->depth;
+  record_event(state, -2);
+}
+
+static
+int
+recording_forward(
+    void *raw_state)
+{
+  recording_state_t *state = (recording_state_t*) raw_state;
+
+  record_event(state, -3);
+  return 0 != ++ state->forward_count % state->forward_period;
+}
+
+static
+void
+recording_backward(
+    void *raw_state)
+{
+  record_event((recording_state_t*) raw_state, -4);
+}
+
+static
+void
+recording_post_visitor(
+    list_tree_node_t *node,
+    void *raw_state)
+{
+  record_event((recording_state_t*) raw_state, -(long) list_tree_get_data(node));
+}
+
+static
+int
+counting_pre_visitor(
+    list_tree_node_t *_,
+    void *count)
+{
+  ++ *(size_t*) count;
+  return 1;
+}
+
+static
+void
+test_multi()
+{
+  enum { BUNDLE_COUNT = 5 };
+
+  static recording_state_t const rules[BUNDLE_COUNT] =
+  {
+    { 10, 0, 1000 },
+    { 2, 0, 1000 },
+    { 10, 2, 1000 },
+    { 10, 0, 3 },
+    { 3, 3, 5 }
+  };
+
+  list_tree_node_t *tree = make_wrapped_int_tree(3, 4);
+  recording_state_t *solo = (recording_state_t*) malloc(
+      BUNDLE_COUNT * sizeof(recording_state_t));
+  recording_state_t *combined = (recording_state_t*) malloc(
+      BUNDLE_COUNT * sizeof(recording_state_t));
+  list_tree_visitor_bundle_t bundles[BUNDLE_COUNT];
+
+  assert(NULL != solo && NULL != combined);
+
+  /* Odd bundles come back on the way up, even ones do not */
+  for (size_t i = 0; i < BUNDLE_COUNT; ++i)
+  {
+    int is_returning = i % 2;
+
+    solo[i] = combined[i] = rules[i];
+
+    list_tree_visitor_bundle_t bundle =
+    {
+      recording_pre_visitor,
+      recording_descent,
+      recording_ascent,
+      recording_forward,
+      is_returning ? recording_backward : NULL,
+      is_returning ? recording_post_visitor : NULL,
+      &combined[i]
+    };
+
+    bundles[i] = bundle;
+
+    list_tree_traverse_depth(
+        tree,
+        bundle.pre_visitor,
+        bundle.descent,
+        bundle.ascent,
+        bundle.forward,
+        bundle.backward,
+        bundle.post_visitor,
+        &solo[i]);
+  }
+
+  list_tree_traverse_multi(tree, bundles, BUNDLE_COUNT);
+
+  for (size_t i = 0; i < BUNDLE_COUNT; ++i)
+  {
+    assert(0 != solo[i].size);
+    assert(solo[i].size == combined[i].size);
+    assert(0 == memcmp(solo[i].events, combined[i].events, solo[i].size * sizeof(long)));
+  }
+
+  free(combined);
+  free(solo);
+
+  /* Pruning in every bundle stops the walk */
+  list_tree_visitor_bundle_t pruning = { NULL, enter_false, NULL, enter_false, NULL, NULL, NULL };
+  list_tree_visitor_bundle_t many[LIST_TREE_MAX_BUNDLES];
+  size_t count = 0;
+
+  for (size_t i = 0; i < LIST_TREE_MAX_BUNDLES; ++i)
+    many[i] = pruning;
+
+  many[LIST_TREE_MAX_BUNDLES - 1].pre_visitor = counting_pre_visitor;
+  many[LIST_TREE_MAX_BUNDLES - 1].state = &count;
+
+  list_tree_traverse_multi(tree, many, LIST_TREE_MAX_BUNDLES);
+  assert(1 == count);
+
+  list_tree_dispose(tree, NULL);
+}
+
+/* Checks that nodes come in pre-order at a constant positive stride */
+typedef struct _address_state_t
+{
+  char const* last;
+  ptrdiff_t stride;
+  size_t count;
+} address_state_t;
+
+static
+int
+address_checking_pre_visitor(
+    list_tree_node_t *node,
+    void *raw_state)
+{
+  address_state_t *state = (address_state_t*) raw_state;
+  char const* address = (char const*) node;
+
+  if (NULL != state->last)
+  {
+    if (0 == state->stride)
+      state->stride = address - state->last;
+
+    assert(0 < state->stride);
+    assert(address - state->last == state->stride);
+  }
+
+  state->last = address;
+  ++ state->count;
+  return 1;
+}
+
+static
+void
+test_compact()
+{
+  list_tree_node_t *tree = make_wrapped_int_tree(3, 4);
+  recording_state_t *plain = (recording_state_t*) malloc(sizeof(recording_state_t));
+  recording_state_t *prefetched = (recording_state_t*) malloc(sizeof(recording_state_t));
+  recording_state_t const rule = { 10, 3, 5 };
+
+  assert(NULL != plain && NULL != prefetched);
+
+  *plain = *prefetched = rule;
+
+  list_tree_traverse_depth(
+      tree,
+      recording_pre_visitor,
+      recording_descent,
+      recording_ascent,
+      recording_forward,
+      recording_backward,
+      recording_post_visitor,
+      plain);
+
+  list_tree_traverse_prefetch(
+      tree,
+      recording_pre_visitor,
+      recording_descent,
+      recording_ascent,
+      recording_forward,
+      recording_backward,
+      recording_post_visitor,
+      prefetched);
+
+  assert(0 != plain->size);
+  assert(plain->size == prefetched->size);
+  assert(0 == memcmp(plain->events, prefetched->events, plain->size * sizeof(long)));
+
+  FILE *scattered_output = tmpfile();
+  FILE *compact_output = tmpfile();
+  size_t size = list_tree_size(tree);
+  list_tree_arena_t *arena = list_tree_arena_create(7);
+
+  list_tree_write(tree, wrapped_int_writer, scattered_output, "\t", "{\n", "}\n");
+  list_tree_arena_compact(arena, &tree);
+  list_tree_write(tree, wrapped_int_writer, compact_output, "\t", "{\n", "}\n");
+
+  assert(same_output(scattered_output, compact_output));
+  assert(list_tree_arena_count(arena) == size);
+
+  address_state_t addresses = { NULL, 0, 0 };
+
+  list_tree_traverse_prefetch(
+      tree,
+      address_checking_pre_visitor,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      &addresses);
+
+  assert(size == addresses.count);
+
+  /* A long list needs no more than a constant stack */
+  list_tree_node_t *list = make_long_list(test_long_list_length);
+
+  list_tree_arena_compact(arena, &list);
+
+  assert(list_tree_length(list) == test_long_list_length);
+  assert(list_tree_arena_count(arena) == size + test_long_list_length);
+
+  list_tree_node_t *empty = NULL;
+
+  list_tree_arena_compact(arena, &empty);
+  assert(NULL == empty);
+
+  fclose(scattered_output);
+  fclose(compact_output);
+  free(prefetched);
+  free(plain);
+  list_tree_arena_release(arena, NULL);
+}
+
+static size_t hashed_count;
+
+static
+size_t
+counting_hasher(
+    void const* data)
+{
+  ++ hashed_count;
+  return (size_t) data;
+}
+
+static
+size_t
+long_value_hasher(
+    void const* data)
+{
+  return (size_t) *(long const*) data;
+}
+
+static
+list_tree_node_t*
+make_augmented_copy(
+    list_tree_node_t *tree)
+{
+  if (NULL == tree)
+    return NULL;
+
+  return list_tree_make_augmented(
+      list_tree_get_data(tree),
+      make_augmented_copy(list_tree_get_next(tree)),
+      make_augmented_copy(list_tree_get_first_child(tree)));
+}
+
+typedef struct _diff_state_t
+{
+  size_t count;
+  size_t path[8];
+  size_t path_length;
+  list_tree_node_t *a;
+  list_tree_node_t *b;
+} diff_state_t;
+
+static
+int
+recording_diff_visitor(
+    size_t const* path,
+    size_t path_length,
+    list_tree_node_t *a,
+    list_tree_node_t *b,
+    void *raw_state)
+{
+  diff_state_t *state = (diff_state_t*) raw_state;
+
+  assert(path_length <= sizeof(state->path) / sizeof(size_t));
+
+  memcpy(state->path, path, path_length * sizeof(size_t));
+  state->path_length = path_length;
+  state->a = a;
+  state->b = b;
+
+  return 0 != ++ state->count % 2;
+}
+
+static
+void
+test_hash()
+{
+  list_tree_node_t *plain = make_wrapped_int_tree(3, 4);
+  list_tree_node_t *other = make_wrapped_int_tree(3, 4);
+  list_tree_node_t *augmented = make_augmented_copy(plain);
+  size_t hash = list_tree_hash(plain, counting_hasher);
+
+  assert(0 != hash);
+  assert(0 == list_tree_hash(NULL, counting_hasher));
+  assert(hash == list_tree_hash(other, counting_hasher));
+  assert(hash == list_tree_hash(augmented, counting_hasher));
+  assert(hash != list_tree_hash(list_tree_get_next(plain), counting_hasher));
+
+  assert(list_tree_equal(plain, other, counting_hasher, wrapped_int_comparer));
+  assert(list_tree_equal(plain, augmented, counting_hasher, NULL));
+  assert(!list_tree_equal(plain, NULL, counting_hasher, wrapped_int_comparer));
+
+  /* Plain trees are compared up to the first difference only */
+  hashed_count = 0;
+  assert(!list_tree_equal(plain, list_tree_get_next(plain), counting_hasher, NULL));
+  assert(2 == hashed_count);
+
+  diff_state_t diff = { 0 };
+
+  list_tree_diff(plain, other, counting_hasher, recording_diff_visitor, &diff);
+  assert(0 == diff.count);
+
+  /* Whole root list missing, the visitor stops after two nodes */
+  list_tree_diff(plain, NULL, counting_hasher, recording_diff_visitor, &diff);
+  assert(2 == diff.count);
+  assert(1 == diff.path_length && 1 == diff.path[0]);
+  assert(list_tree_get_next(plain) == diff.a && NULL == diff.b);
+
+  /* Cached hashes are recomputed along the path to a change only */
+  static const size_t path[] = { 1, 0, 2, 2 };
+  list_tree_node_t *target = list_tree_locate(augmented, path, 4);
+  size_t size = list_tree_size(augmented);
+
+  list_tree_append(target, list_tree_make_augmented((void*) 0x7777L, NULL, NULL));
+
+  hashed_count = 0;
+  assert(hash != list_tree_hash(augmented, counting_hasher));
+  assert(0 < hashed_count && hashed_count < size / 4);
+
+  hashed_count = 0;
+  list_tree_hash(augmented, counting_hasher);
+  assert(0 == hashed_count);
+
+  assert(!list_tree_equal(plain, augmented, counting_hasher, NULL));
+
+  list_tree_node_t *copy = make_augmented_copy(plain);
+  list_tree_hash(copy, counting_hasher);
+
+  diff.count = 0;
+  hashed_count = 0;
+  list_tree_diff(copy, augmented, counting_hasher, recording_diff_visitor, &diff);
+
+  assert(1 == diff.count);
+  assert(4 == diff.path_length);
+  assert(0 == memcmp(diff.path, (size_t[]) { 1, 0, 2, 3 }, 4 * sizeof(size_t)));
+  assert(NULL == diff.a && (void*) 0x7777L == list_tree_get_data(diff.b));
+  assert(hashed_count < size / 4);
+
+  /* Augmented trees with cached hashes are told apart at once */
+  hashed_count = 0;
+  assert(!list_tree_equal(copy, augmented, counting_hasher, NULL));
+  assert(0 == hashed_count);
+
+  /* Data changed in place needs explicit invalidation */
+  long values[] = { 1, 2, 3 };
+  list_tree_node_t *list = list_tree_make_augmented(
+      &values[0],
+      NULL,
+      list_tree_make_augmented(
+        &values[1],
+        NULL,
+        list_tree_make_augmented(&values[2], NULL, NULL)));
+  list_tree_node_t *middle = list_tree_get_first_child(list);
+  size_t list_hash = list_tree_hash(list, long_value_hasher);
+
+  values[1] = 5;
+  assert(list_hash == list_tree_hash(list, long_value_hasher));
+
+  list_tree_hash_invalidate(middle);
+  assert(list_hash != list_tree_hash(list, long_value_hasher));
+
+  values[1] = 2;
+  list_tree_hash_invalidate(middle);
+  assert(list_hash == list_tree_hash(list, long_value_hasher));
+
+  list_tree_dispose(list, NULL);
+  list_tree_dispose(copy, NULL);
+  list_tree_dispose(augmented, NULL);
+  list_tree_dispose(other, NULL);
+  list_tree_dispose(plain, NULL);
+}
+
 int main()
 {
   test_print();
@@ -180,6 +2473,29 @@ int main()
   test_metrics();
   test_find();
   test_locate();
+  test_long_list();
+  test_arena();
+  test_inline();
+  test_builder();
+  test_reclaimer();
+  test_persistent();
+  test_concurrent();
+  test_frozen();
+  test_locator();
+  test_cursor();
+  test_breadth();
+  test_multi();
+  test_compact();
+  test_lazy();
+  test_augmented();
+  test_hash();
+  test_binary();
+  test_read();
+  test_sink();
+  test_shapes();
+  test_stats();
+  test_parallel();
+  test_generate();
 
   fputs("All tests passed\n", stdout);
 
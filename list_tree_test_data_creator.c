@@ -1,4 +1,9 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include "list_tree.h"
+#include "list_tree_arena.h"
+#include "list_tree_parallel.h"
 #include "list_tree_test_data_creator.h"
 
 typedef struct _bound_t
@@ -43,10 +48,43 @@ int wrapped_int_generator(
   return 1;
 }
 
+/*
+  The same keys from the context: the parent's key shifted by one
+  digit plus the position of the node, without walking the path.
+*/
+static
+int wrapped_int_generator_ex(
+    generator_context_t const* context,
+    void *raw_state,
+    void **data)
+{
+  bound_t *state = (bound_t*) raw_state;
+
+  if (context->index == state->length || context->depth == state->depth)
+    return 0;
+
+  long parent = (long) context->parent_data;
+
+  *data = (void*) ((long) (1 + context->index) + (parent << 4));
+  return 1;
+}
+
 list_tree_node_t*
 make_wrapped_int_tree(
     size_t length,
     size_t depth)
+{
+  return make_wrapped_int_tree_in_arena(
+      NULL,
+      length,
+      depth);
+}
+
+list_tree_node_t*
+make_wrapped_int_tree_in_arena(
+    list_tree_arena_t *arena,
+    size_t length,
+    size_t depth)
 {
   bound_t bound =
   {
@@ -54,8 +92,163 @@ make_wrapped_int_tree(
     depth
   };
 
-  return list_tree_generate(
-      wrapped_int_generator,
+  return list_tree_arena_generate_ex(
+      arena,
+      wrapped_int_generator_ex,
       &bound);
 }
 
+list_tree_node_t*
+make_wrapped_int_tree_parallel(
+    list_tree_arena_t *arena,
+    size_t length,
+    size_t depth,
+    size_t thread_count)
+{
+  bound_t bound =
+  {
+    length,
+    depth
+  };
+
+  return list_tree_generate_parallel(
+      arena,
+      wrapped_int_generator,
+      &bound,
+      NULL,
+      NULL,
+      thread_count);
+}
+
+enum { FILE_SYSTEM_DIRECTORY_ODDS = 4 };
+
+typedef struct _shape_state_t
+{
+  tree_shape_params_t params;
+  uint64_t random;
+  size_t count;
+  size_t root_length;
+} shape_state_t;
+
+static
+uint64_t
+shape_random(
+    shape_state_t *state)
+{
+  uint64_t x = state->random;
+
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  state->random = x;
+
+  return x * 0x2545F4914F6CDD1DULL;
+}
+
+static
+size_t
+shape_child_count(
+    shape_state_t *state,
+    size_t depth)
+{
+  tree_shape_params_t const* params = &state->params;
+  size_t max_fan_out = params->max_fan_out;
+
+  switch (params->shape)
+  {
+    case TREE_SHAPE_CHAIN:
+      return 1;
+
+    case TREE_SHAPE_LIST:
+      return 0;
+
+    default:
+      break;
+  }
+
+  if (depth + 1 >= params->max_depth || 0 == max_fan_out)
+    return 0;
+
+  uint64_t random = shape_random(state);
+  size_t count = 0;
+
+  switch (params->shape)
+  {
+    case TREE_SHAPE_RANDOM:
+      count = random % (max_fan_out + 1);
+      break;
+
+    case TREE_SHAPE_POWER_LAW:
+      while ((random & 1) && count < max_fan_out)
+      {
+        count = 2 * count + 1;
+        random >>= 1;
+      }
+      break;
+
+    case TREE_SHAPE_FILE_SYSTEM:
+      if (0 == random % FILE_SYSTEM_DIRECTORY_ODDS)
+        count = 1 + (random >> 8) % max_fan_out;
+      break;
+
+    default:
+      break;
+  }
+
+  return count < max_fan_out ? count : max_fan_out;
+}
+
+/*
+  The length of each list is drawn when its first node is asked
+  for, right after its parent is generated, and is kept in the
+  scratch slot of the list as length + 1.
+*/
+static
+int
+shape_generator(
+    generator_context_t const* context,
+    void *raw_state,
+    void **data)
+{
+  shape_state_t *state = (shape_state_t*) raw_state;
+
+  if (state->count == state->params.size)
+    return 0;
+
+  if (NULL == *context->scratch)
+  {
+    size_t length = 0 == context->depth
+      ? state->root_length
+      : shape_child_count(state, context->depth - 1);
+
+    *context->scratch = (void*) (uintptr_t) (length + 1);
+  }
+
+  if (context->index + 1 >= (uintptr_t) *context->scratch)
+    return 0;
+
+  *data = (void*) (long) state->count ++;
+
+  return 1;
+}
+
+list_tree_node_t*
+make_shaped_tree(
+    list_tree_arena_t *arena,
+    tree_shape_params_t const* params)
+{
+  assert(NULL != params);
+
+  shape_state_t state;
+
+  state.params = *params;
+  state.random = 0x9E3779B97F4A7C15ULL ^ params->seed;
+  state.count = 0;
+  state.root_length =
+    TREE_SHAPE_CHAIN == params->shape ? 1 : params->size;
+
+  return list_tree_arena_generate_ex(
+      arena,
+      shape_generator,
+      &state);
+}
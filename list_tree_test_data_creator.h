@@ -2,10 +2,70 @@
 #define _LIST_TREE_TEST_DATA_CREATOR_H_
 
 #include "list_tree.h"
+#include "list_tree_arena.h"
 
 list_tree_node_t*
 make_wrapped_int_tree(
     size_t length,
     size_t depth);
 
+list_tree_node_t*
+make_wrapped_int_tree_in_arena(
+    list_tree_arena_t *arena,
+    size_t length,
+    size_t depth);
+
+list_tree_node_t*
+make_wrapped_int_tree_parallel(
+    list_tree_arena_t *arena,
+    size_t length,
+    size_t depth,
+    size_t thread_count);
+
+/*
+  Shapes of large trees for stress tests and benchmarks:
+  - random: each node has 0 to max_fan_out children, uniformly;
+  - power law: the number of children of a node is 2^k - 1 with
+    probability 2^-(k+1), capped at max_fan_out;
+  - chain: a single node on each level;
+  - list: a single list of all nodes;
+  - file system: a node is a directory with probability 1/4 and
+    then has 1 to max_fan_out children, otherwise it is a file.
+  Apart from the chain and the list, no node deeper than
+  max_depth has children, and the root list grows until the tree
+  has the requested size.  The data of a node is its number in
+  depth-first order.
+*/
+typedef enum _tree_shape_t
+{
+  TREE_SHAPE_RANDOM,
+  TREE_SHAPE_POWER_LAW,
+  TREE_SHAPE_CHAIN,
+  TREE_SHAPE_LIST,
+  TREE_SHAPE_FILE_SYSTEM
+} tree_shape_t;
+
+typedef struct _tree_shape_params_t
+{
+  tree_shape_t shape;
+  size_t size;
+  size_t max_fan_out;
+  size_t max_depth;
+  unsigned long seed;
+} tree_shape_params_t;
+
+/*
+  Generation takes O(1) per node: the depth comes with the
+  context of the extended generator, and the length of each list,
+  drawn when its first node is asked for, is kept in the scratch
+  slot of the list.  The lengths are drawn from a single random
+  sequence and the data count the nodes generated so far, so the
+  generator relies on being called in depth-first order and cannot
+  be used for parallel generation.
+*/
+list_tree_node_t*
+make_shaped_tree(
+    list_tree_arena_t *arena,
+    tree_shape_params_t const* params);
+
 #endif